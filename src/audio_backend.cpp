@@ -0,0 +1,32 @@
+//
+//  audio_backend.cpp
+//  audiosample
+//
+
+#include "audio_backend.h"
+
+AudioBackend * AudioBackend::Create(Type type)
+{
+	switch (type)
+	{
+#if AUDIO_CONFIG_FMOD
+		case kFMODStream:
+		case kFMODDSP:
+			return CreateFMODBackend(type);
+#endif
+		case kNull:
+			return CreateNullBackend(false);
+			
+		case kNullRealtime:
+			return CreateNullBackend(true);
+			
+		default:
+			return nullptr;
+	}
+}
+
+void AudioBackend::Destroy(AudioBackend *& backend)
+{
+	delete backend;
+	backend = nullptr;
+}
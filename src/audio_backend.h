@@ -0,0 +1,83 @@
+//
+//  audio_backend.h
+//  audiosample
+//
+
+#ifndef audio_backend_h
+#define audio_backend_h
+
+#include <stdint.h>
+
+// builds without an FMOD runtime (headless build boxes) set this to 0,
+// which leaves only the null backends
+#ifndef AUDIO_CONFIG_FMOD
+#	define AUDIO_CONFIG_FMOD 1
+#endif
+
+class AudioSubmodule;
+
+// An output backend owns the device (or the lack of one): it initializes
+// output, decides when blocks get pulled from the AudioSubmodule's mixer,
+// and keeps the clock of how much has been delivered.  Nothing outside
+// the backend implementations knows about FMOD.
+class AudioBackend
+{
+public:
+	enum Type
+	{
+		// FMOD user stream, read ahead by FMOD's decode buffer
+		kFMODStream,
+
+		// FMOD dsp on the master channel group, rendered directly in
+		// FMOD's mixer; shortest trigger latency
+		kFMODDSP,
+
+		// no device, a thread pulls blocks as fast as the cpu allows
+		kNull,
+
+		// no device, a thread pulls blocks paced to the wall clock
+		kNullRealtime,
+	};
+
+	struct Format
+	{
+		// 0 runs at whatever rate the device prefers
+		int32_t hertz = 0;
+		int32_t channels = 1;
+
+		// block size for backends that choose their own, ignored by FMOD
+		int32_t blockFrames = 512;
+	};
+
+	static AudioBackend * Create(Type type);
+	static void Destroy(AudioBackend *& backend);
+
+	// starts output; format may be adjusted to what the device runs at.
+	// returns false and leaves GetError set when the device can't start
+	virtual bool Init(AudioSubmodule * engine, Format & format) = 0;
+	virtual void Update() = 0;
+	virtual void Shutdown() = 0;
+
+	// frames delivered to the output since Init
+	virtual uint64_t GetClock() const = 0;
+
+	// seconds between a block being rendered and it reaching the device
+	virtual float GetOutputLatency() const = 0;
+
+	virtual const char * GetName() const = 0;
+
+	const char * GetError() const { return error; }
+
+	virtual ~AudioBackend() {}
+
+protected:
+	const char * error = nullptr;
+};
+
+// per backend factories, used by AudioBackend::Create
+#if AUDIO_CONFIG_FMOD
+AudioBackend * CreateFMODBackend(AudioBackend::Type type);
+#endif
+AudioBackend * CreateNullBackend(bool realtime);
+
+#endif /* audio_backend_h */
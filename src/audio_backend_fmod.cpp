@@ -0,0 +1,336 @@
+//
+//  audio_backend_fmod.cpp
+//  audiosample
+//
+
+#include "audio_backend.h"
+
+#if AUDIO_CONFIG_FMOD
+
+#include <fmod/fmod_errors.h>
+#include <fmod/fmod.hpp>
+#include <atomic>
+#include <string.h>
+#include "audio_mix.h"
+#include "audio_module.h"
+
+class FMODBackend : public AudioBackend
+{
+	FMOD::System *system = nullptr;
+
+	// every AudioStream is summed into one bus; depending on the type it
+	// reaches FMOD either as a single user stream, or as a dsp on the
+	// master channel group that renders inside FMOD's mixer
+	FMOD::Sound *buffer = nullptr;
+	FMOD::Channel *channel = nullptr;
+	FMOD::DSP *dsp = nullptr;
+	const float bufferLength = 2.0f; // in seconds
+	const float decodeBufferLength = 0.4f; // in seconds, FMOD's default
+
+	// the bus on the dsp path; FMOD's mixer runs the bus's own speaker
+	// layout, so its channels line up one to one
+	float * busSpace = nullptr;
+	int32_t busFrames = 0;
+
+	Type type;
+	Format format;
+	AudioSubmodule * engine = nullptr;
+	std::atomic<uint64_t> clock { 0 };
+
+	bool Check(FMOD_RESULT result);
+	bool CreateMasterStream();
+	bool CreateMasterDSP();
+
+public:
+	FMODBackend(Type type) : type(type) {}
+
+	// called from FMOD's stream thread or mixer thread
+	void ReadStream(float * buffer, int32_t numFrames);
+	void ReadDSP(const float * inBuffer, int32_t inChannels, float * outBuffer, int32_t outChannels, int32_t numFrames);
+
+	bool Init(AudioSubmodule * engine, Format & format) override;
+	void Update() override;
+	void Shutdown() override;
+
+	uint64_t GetClock() const override { return clock.load(std::memory_order_relaxed); }
+	float GetOutputLatency() const override;
+	const char * GetName() const override { return type == kFMODDSP ? "fmod-dsp" : "fmod-stream"; }
+};
+
+// FMOD's layout for the bus's channel count, in the order PanGains pans
+// over; counts FMOD has no name for go out as raw speakers
+static FMOD_SPEAKERMODE GetSpeakerMode(int32_t channels)
+{
+	switch (channels)
+	{
+		case 1: return FMOD_SPEAKERMODE_MONO;
+		case 2: return FMOD_SPEAKERMODE_STEREO;
+		case 4: return FMOD_SPEAKERMODE_QUAD;
+		case 5: return FMOD_SPEAKERMODE_SURROUND;
+		case 6: return FMOD_SPEAKERMODE_5POINT1;
+		case 8: return FMOD_SPEAKERMODE_7POINT1;
+		default: return FMOD_SPEAKERMODE_RAW;
+	}
+}
+
+FMOD_RESULT F_CALL PCMReadCallback_Mixer(FMOD_SOUND * soundraw, void * data, unsigned int datalen)
+{
+	int32_t numChannels = 1;
+	int32_t numBits = 32;
+
+	FMOD_SOUND_FORMAT format;
+	FMOD_SOUND_TYPE type;
+	FMOD_Sound_GetFormat(soundraw, &type, &format, &numChannels, &numBits);
+
+	const int32_t bufferLen = datalen / sizeof(float);
+	const int32_t numFrames = bufferLen / numChannels;
+
+	float * buffer = (float *) data;
+
+	//over write with zeroes to make sure we have no garbage in
+	// in there to begin with
+	AudioMix::Zero(buffer, bufferLen);
+
+	FMODBackend * backend;
+	FMOD_Sound_GetUserData(soundraw, (void**) &backend);
+
+	if (backend)
+		backend->ReadStream(buffer, numFrames);
+	else
+		return FMOD_ERR_INVALID_PARAM;
+
+	return FMOD_OK;
+}
+
+FMOD_RESULT F_CALL DSPReadCallback_Mixer(FMOD_DSP_STATE * dspState, float * inBuffer, float * outBuffer, unsigned int length, int inChannels, int * outChannels)
+{
+	FMODBackend * backend;
+	FMOD_DSP_GETUSERDATA(dspState, (void**) &backend);
+
+	if (backend)
+		backend->ReadDSP(inBuffer, inChannels, outBuffer, *outChannels, int32_t(length));
+	else
+		return FMOD_ERR_INVALID_PARAM;
+
+	return FMOD_OK;
+}
+
+FMOD_RESULT F_CALL PCMSetPosCallback_Null(FMOD_SOUND * soundraw, int subsound, unsigned int position, FMOD_TIMEUNIT postype)
+{
+	return FMOD_OK;
+}
+
+bool FMODBackend::Check(FMOD_RESULT result)
+{
+	if (result == FMOD_OK)
+		return true;
+
+	error = FMOD_ErrorString(result);
+	engine->PostError(error);
+	return false;
+}
+
+void FMODBackend::ReadStream(float * buffer, int32_t numFrames)
+{
+	engine->Mix(buffer, numFrames);
+	clock.fetch_add(numFrames, std::memory_order_relaxed);
+}
+
+void FMODBackend::ReadDSP(const float * inBuffer, int32_t inChannels, float * outBuffer, int32_t outChannels, int32_t numFrames)
+{
+	// the dsp block is far shorter than the bus, but stay safe if FMOD
+	// is ever configured with enormous buffers
+	for (int32_t start = 0; start < numFrames; start += busFrames)
+	{
+		int32_t frames = numFrames - start;
+		if (frames > busFrames)
+			frames = busFrames;
+
+		AudioMix::Zero(busSpace, frames * format.channels);
+		engine->Mix(busSpace, frames);
+
+		const float * in = inBuffer + start * inChannels;
+		float * out = outBuffer + start * outChannels;
+
+		// pass through whatever else FMOD is playing and add the bus on
+		// top; a channel the bus doesn't have gets none of it, rather than
+		// a copy of some other speaker's
+		for (int32_t frame = 0; frame < frames; frame++)
+		{
+			const float * bus = busSpace + frame * format.channels;
+			for (int32_t c = 0; c < outChannels; c++)
+			{
+				const float dry = c < inChannels ? in[frame * inChannels + c] : 0.0f;
+				out[frame * outChannels + c] = dry + (c < format.channels ? bus[c] : 0.0f);
+			}
+		}
+	}
+
+	clock.fetch_add(numFrames, std::memory_order_relaxed);
+}
+
+float FMODBackend::GetOutputLatency() const
+{
+	if (!system || error)
+		return 0.0f;
+
+	unsigned int dspBufferLength = 0;
+	int dspNumBuffers = 0;
+	system->getDSPBufferSize(&dspBufferLength, &dspNumBuffers);
+
+	float latency = float(dspBufferLength * dspNumBuffers) / float(format.hertz);
+
+	// the user stream sits behind its own decode buffer on top of the mixer
+	if (type == kFMODStream)
+		latency += decodeBufferLength;
+
+	return latency;
+}
+
+bool FMODBackend::CreateMasterStream()
+{
+	FMOD_MODE mode = FMOD_OPENUSER | FMOD_CREATESTREAM | FMOD_LOOP_NORMAL;
+
+	FMOD_CREATESOUNDEXINFO info = {0};
+	info.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
+	info.length = uint32_t(bufferLength * format.hertz * format.channels * sizeof(float));
+	info.numchannels = format.channels;
+	info.defaultfrequency = format.hertz;
+	info.format = FMOD_SOUND_FORMAT_PCMFLOAT;
+	info.decodebuffersize = uint32_t(decodeBufferLength * format.hertz);
+	info.pcmreadcallback = PCMReadCallback_Mixer;
+	info.pcmsetposcallback = PCMSetPosCallback_Null;
+	info.userdata = (void *) this;
+
+	if (!Check(system->createStream("", mode, &info, &buffer)))
+		return false;
+
+	return Check(system->playSound(buffer, nullptr, false, &channel));
+}
+
+bool FMODBackend::CreateMasterDSP()
+{
+	// the mixer never asks for more than one dsp block at a time
+	unsigned int dspBufferLength = 0;
+	int dspNumBuffers = 0;
+	if (!Check(system->getDSPBufferSize(&dspBufferLength, &dspNumBuffers)))
+		return false;
+
+	busFrames = int32_t(dspBufferLength);
+	busSpace = AudioBuffer::Allocate(busFrames, format.channels);
+
+	FMOD_DSP_DESCRIPTION desc = {0};
+	desc.pluginsdkversion = FMOD_PLUGIN_SDK_VERSION;
+	strncpy(desc.name, "AudioSubmodule Mixer", sizeof(desc.name) - 1);
+	desc.version = 1;
+	desc.numinputbuffers = 1;
+	desc.numoutputbuffers = 1;
+	desc.read = DSPReadCallback_Mixer;
+	desc.userdata = (void *) this;
+
+	if (!Check(system->createDSP(&desc, &dsp)))
+		return false;
+
+	FMOD::ChannelGroup * master = nullptr;
+	if (!Check(system->getMasterChannelGroup(&master)))
+		return false;
+
+	return Check(master->addDSP(FMOD_CHANNELCONTROL_DSP_HEAD, dsp));
+}
+
+bool FMODBackend::Init(AudioSubmodule * audio, Format & initFormat)
+{
+	engine = audio;
+	format = initFormat;
+
+	if (!Check(FMOD::System_Create(&system)))      // Create the main system object.
+	{
+		system = nullptr;
+		return false;
+	}
+
+	// run FMOD's mixer at the device's own rate unless told otherwise,
+	// so nothing gets resampled on the way out
+	if (format.hertz <= 0)
+	{
+		int systemRate = 0;
+		if (system->getDriverInfo(0, nullptr, 0, nullptr, &systemRate, nullptr, nullptr) != FMOD_OK || systemRate <= 0)
+			systemRate = 48000;
+		format.hertz = systemRate;
+	}
+
+	// the mixer runs in the bus's layout and FMOD maps that onto the
+	// device's speakers, downmixing a 5.1 bus to stereo and so on
+	const FMOD_SPEAKERMODE speakerMode = GetSpeakerMode(format.channels);
+	const int rawSpeakers = speakerMode == FMOD_SPEAKERMODE_RAW ? format.channels : 0;
+	if (!Check(system->setSoftwareFormat(format.hertz, speakerMode, rawSpeakers)))
+		return false;
+
+	if (!Check(system->init(32, FMOD_INIT_NORMAL, 0)))    // Initialize FMOD.
+		return false;
+
+	// FMOD may still have picked something else; whatever it runs at is
+	// what the writers have to render at
+	int mixerRate = 0;
+	FMOD_SPEAKERMODE mixerMode = speakerMode;
+	int mixerRawSpeakers = 0;
+	if (system->getSoftwareFormat(&mixerRate, &mixerMode, &mixerRawSpeakers) == FMOD_OK)
+	{
+		if (mixerRate > 0)
+			format.hertz = mixerRate;
+
+		int mixerChannels = mixerRawSpeakers;
+		if (mixerMode != FMOD_SPEAKERMODE_RAW)
+			system->getSpeakerModeChannels(mixerMode, &mixerChannels);
+		if (mixerChannels > 0 && mixerChannels <= AudioMix::kMaxChannels)
+			format.channels = mixerChannels;
+	}
+
+	initFormat = format;
+
+	if (type == kFMODDSP)
+		return CreateMasterDSP();
+
+	return CreateMasterStream();
+}
+
+void FMODBackend::Update()
+{
+	if (system)
+		system->update();
+}
+
+void FMODBackend::Shutdown()
+{
+	if (channel)
+		channel->stop();
+
+	if (buffer)
+		buffer->release();
+
+	if (dsp)
+	{
+		FMOD::ChannelGroup * master = nullptr;
+		if (system->getMasterChannelGroup(&master) == FMOD_OK)
+			master->removeDSP(dsp);
+		dsp->release();
+	}
+
+	if (system)
+		system->release();
+
+	channel = nullptr;
+	buffer = nullptr;
+	dsp = nullptr;
+	system = nullptr;
+
+	AudioBuffer::Free(busSpace);
+	busSpace = nullptr;
+}
+
+AudioBackend * CreateFMODBackend(AudioBackend::Type type)
+{
+	return new FMODBackend(type);
+}
+
+#endif // AUDIO_CONFIG_FMOD
@@ -0,0 +1,112 @@
+//
+//  audio_backend_null.cpp
+//  audiosample
+//
+
+#include "audio_backend.h"
+
+#include <bx/os.h>
+#include <bx/thread.h>
+#include <bx/timer.h>
+#include <atomic>
+#include "audio_mix.h"
+#include "audio_module.h"
+
+// Renders into a throwaway buffer on its own thread, standing in for a
+// device.  Unpaced it runs the mixer flat out, which is what benchmarks
+// want; paced it sleeps to hold the block rate to the wall clock, which
+// is what a headless game session wants.
+class NullBackend : public AudioBackend
+{
+	bx::Thread thread;
+	std::atomic<bool> running { false };
+	std::atomic<uint64_t> clock { 0 };
+
+	AudioSubmodule * engine = nullptr;
+	Format format;
+	bool realtime;
+
+	float * buffer = nullptr;
+
+	static int32_t ThreadFunc(bx::Thread * self, void * userData);
+	void Run();
+
+public:
+	NullBackend(bool realtime) : realtime(realtime) {}
+
+	bool Init(AudioSubmodule * engine, Format & format) override;
+	void Update() override {}
+	void Shutdown() override;
+
+	uint64_t GetClock() const override { return clock.load(std::memory_order_relaxed); }
+	float GetOutputLatency() const override { return 0.0f; }
+	const char * GetName() const override { return realtime ? "null-realtime" : "null"; }
+};
+
+int32_t NullBackend::ThreadFunc(bx::Thread * self, void * userData)
+{
+	((NullBackend *) userData)->Run();
+	return 0;
+}
+
+void NullBackend::Run()
+{
+	const int32_t numSamples = format.blockFrames * format.channels;
+	const int64_t frequency = bx::getHPFrequency();
+	const int64_t startTick = bx::getHPCounter();
+
+	while (running.load(std::memory_order_acquire))
+	{
+		AudioMix::Zero(buffer, numSamples);
+		engine->Mix(buffer, format.blockFrames);
+
+		const uint64_t delivered = clock.fetch_add(format.blockFrames, std::memory_order_relaxed) + format.blockFrames;
+
+		if (realtime)
+		{
+			// sleep until the wall clock catches up with what we've
+			// delivered; pacing against the start keeps drift from
+			// accumulating across blocks
+			const int64_t dueTick = startTick + int64_t(double(delivered) * double(frequency) / double(format.hertz));
+			const int64_t ahead = dueTick - bx::getHPCounter();
+			if (ahead > 0)
+				bx::sleep(uint32_t(ahead * 1000 / frequency));
+		}
+	}
+}
+
+bool NullBackend::Init(AudioSubmodule * audio, Format & initFormat)
+{
+	engine = audio;
+
+	if (initFormat.hertz <= 0)
+		initFormat.hertz = 48000;
+	format = initFormat;
+
+	buffer = AudioBuffer::Allocate(format.blockFrames, format.channels);
+
+	running.store(true, std::memory_order_release);
+	if (!thread.init(ThreadFunc, this, 0, "audio null backend"))
+	{
+		running.store(false, std::memory_order_release);
+		error = "null backend couldn't start its thread";
+		engine->PostError(error);
+		return false;
+	}
+
+	return true;
+}
+
+void NullBackend::Shutdown()
+{
+	if (running.exchange(false))
+		thread.shutdown();
+
+	AudioBuffer::Free(buffer);
+	buffer = nullptr;
+}
+
+AudioBackend * CreateNullBackend(bool realtime)
+{
+	return new NullBackend(realtime);
+}
@@ -0,0 +1,357 @@
+//
+//  audio_bank.cpp
+//  audiosample
+//
+
+#include "audio_bank.h"
+
+#include <bx/file.h>
+#include <bx/hash.h>
+#include <bx/os.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// raw bytes read per pass while decoding a sample into the bank
+static const int32_t kLoadBytes = 1 << 16;
+
+SampleBank * SampleBank::sInstance;
+
+SampleView::SampleView(SampleEntry * viewEntry) : entry(viewEntry)
+{
+	if (entry)
+		entry->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+SampleView::SampleView(const SampleView & other) : SampleView(other.entry)
+{
+}
+
+SampleView & SampleView::operator = (const SampleView & other)
+{
+	if (other.entry)
+		other.entry->refs.fetch_add(1, std::memory_order_relaxed);
+	if (entry)
+		entry->refs.fetch_sub(1, std::memory_order_release);
+
+	entry = other.entry;
+	return *this;
+}
+
+SampleView::~SampleView()
+{
+	if (entry)
+		entry->refs.fetch_sub(1, std::memory_order_release);
+}
+
+const AudioWav::Info & SampleView::GetInfo() const
+{
+	static const AudioWav::Info kEmptyInfo;
+	return IsReady() ? entry->info : kEmptyInfo;
+}
+
+SampleBank::SampleBank()
+{
+	BX_ASSERT(sInstance == nullptr);
+	sInstance = this;
+}
+
+SampleBank::~SampleBank()
+{
+	Shutdown();
+	sInstance = nullptr;
+}
+
+uint32_t SampleBank::HashPath(const char * path)
+{
+	bx::HashMurmur2A hash;
+	hash.begin();
+	hash.add(path, int(strlen(path)));
+	return hash.end();
+}
+
+int32_t SampleBank::ThreadFunc(bx::Thread * self, void * userData)
+{
+	((SampleBank *) userData)->Run();
+	return 0;
+}
+
+void SampleBank::Run()
+{
+	while (running.load(std::memory_order_acquire))
+	{
+		wake.wait();
+
+		while (LoadNext())
+		{
+		}
+	}
+}
+
+// one job per queued load, though any job takes whichever is first
+void SampleBank::LoadJob(void * userData)
+{
+	((SampleBank *) userData)->LoadNext();
+}
+
+// loads the oldest queued sample; false once the queue is empty
+bool SampleBank::LoadNext()
+{
+	uint16_t handle;
+	{
+		bx::MutexScope scope(lock);
+		if (loadQueue.empty())
+			return false;
+		handle = loadQueue.front();
+		loadQueue.pop_front();
+	}
+
+	// queued entries are never evicted, so this is safe unlocked
+	SampleEntry & entry = entries[handle];
+	Load(entry);
+
+	bx::MutexScope scope(lock);
+	residentBytes.fetch_add(entry.bytes, std::memory_order_relaxed);
+	Trim(handle);
+	pendingLoads.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+// called with the lock held; the job is only submitted once it's let go
+void SampleBank::QueueLoad(uint16_t handle)
+{
+	entries[handle].state.store(SampleEntry::kQueued, std::memory_order_relaxed);
+	loadQueue.push_back(handle);
+	pendingLoads.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SampleBank::Load(SampleEntry & entry)
+{
+	bx::FileReader reader;
+	bx::Error err;
+
+	AudioWav::Info info;
+	if (!reader.open(bx::FilePath(entry.path.c_str()), &err) || !AudioWav::ReadInfo(&reader, info) || info.frames <= 0)
+	{
+		entry.state.store(SampleEntry::kFailed, std::memory_order_release);
+		return;
+	}
+
+	const int32_t blockAlign = info.BlockAlign();
+	const uint64_t numSamples = uint64_t(info.frames) * info.channels;
+	float * samples = (float *) malloc(numSamples * sizeof(float));
+
+	// decode in whole frames so a piece never splits one
+	const int32_t pieceFrames = kLoadBytes / blockAlign > 0 ? kLoadBytes / blockAlign : 1;
+	std::vector<uint8_t> raw(pieceFrames * blockAlign);
+
+	reader.seek(info.dataOffset, bx::Whence::Begin);
+
+	bool ok = samples != nullptr;
+	for (int64_t frame = 0; ok && frame < info.frames; frame += pieceFrames)
+	{
+		int64_t frames = info.frames - frame;
+		if (frames > pieceFrames)
+			frames = pieceFrames;
+
+		const int32_t numBytes = int32_t(frames) * blockAlign;
+		ok = reader.read(raw.data(), numBytes, &err) == numBytes;
+		if (ok)
+			AudioWav::Decode(raw.data(), int32_t(frames) * info.channels, info.format, samples + frame * info.channels);
+	}
+
+	reader.close();
+
+	if (!ok)
+	{
+		free(samples);
+		entry.state.store(SampleEntry::kFailed, std::memory_order_release);
+		return;
+	}
+
+	entry.info = info;
+	entry.samples = samples;
+	entry.bytes = numSamples * sizeof(float);
+	entry.state.store(SampleEntry::kReady, std::memory_order_release);
+}
+
+// drops the least recently used sample nobody holds, other than keep
+bool SampleBank::EvictOne(uint16_t keep)
+{
+	for (uint16_t handle = lru.getBack(); handle != bx::kInvalidHandle; handle = lru.getPrev(handle))
+	{
+		const SampleEntry & entry = entries[handle];
+		if (handle == keep || entry.state.load(std::memory_order_relaxed) == SampleEntry::kQueued)
+			continue;
+
+		if (entry.refs.load(std::memory_order_acquire) == 0)
+		{
+			Evict(handle);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SampleBank::Evict(uint16_t handle)
+{
+	SampleEntry & entry = entries[handle];
+
+	residentBytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+	free(entry.samples);
+
+	keys.removeByHandle(handle);
+	lru.free(handle);
+
+	entry.samples = nullptr;
+	entry.bytes = 0;
+	entry.state.store(SampleEntry::kEmpty, std::memory_order_relaxed);
+}
+
+void SampleBank::Trim(uint16_t keep)
+{
+	while (residentBytes.load(std::memory_order_relaxed) > config.budgetBytes && EvictOne(keep))
+	{
+	}
+}
+
+bool SampleBank::Init()
+{
+	return Init(Config());
+}
+
+bool SampleBank::Init(const Config & initConfig)
+{
+	config = initConfig;
+
+	// decoding is background work, so it waits behind audio blocks; a
+	// pool without workers would decode on the game thread, so that gets
+	// the thread instead
+	JobPool * pool = JobPool::Instance();
+	if (pool && pool->GetNumWorkers() > 1)
+	{
+		jobs = pool;
+		running.store(true, std::memory_order_release);
+		return true;
+	}
+
+	running.store(true, std::memory_order_release);
+	if (!thread.init(ThreadFunc, this, 0, "audio sample bank"))
+	{
+		running.store(false, std::memory_order_release);
+		return false;
+	}
+
+	return true;
+}
+
+void SampleBank::Shutdown()
+{
+	const bool wasRunning = running.exchange(false);
+
+	{
+		bx::MutexScope scope(lock);
+		pendingLoads.fetch_sub(int32_t(loadQueue.size()), std::memory_order_relaxed);
+		loadQueue.clear();
+	}
+
+	// jobs still queued find nothing to load; one mid-decode has to finish
+	// before its entry goes away
+	if (jobs)
+	{
+		jobs->Wait(loads);
+		jobs = nullptr;
+	}
+	else if (wasRunning)
+	{
+		wake.post();
+		thread.shutdown();
+	}
+
+	bx::MutexScope scope(lock);
+
+	for (auto & entry : entries)
+	{
+		free(entry.samples);
+		entry.samples = nullptr;
+		entry.bytes = 0;
+		entry.state.store(SampleEntry::kEmpty, std::memory_order_relaxed);
+	}
+
+	lru.reset();
+	keys.reset();
+	residentBytes.store(0, std::memory_order_relaxed);
+}
+
+void SampleBank::WaitForLoads()
+{
+	// the pool runs queued jobs on the waiting thread too
+	if (jobs)
+	{
+		jobs->Wait(loads);
+		return;
+	}
+
+	while (pendingLoads.load(std::memory_order_acquire) > 0)
+		bx::yield();
+}
+
+SampleView SampleBank::Acquire(const char * path)
+{
+	return Acquire(HashPath(path), path);
+}
+
+SampleView SampleBank::Acquire(uint32_t key, const char * path)
+{
+	SampleView view;
+	bool queued = false;
+
+	{
+		bx::MutexScope scope(lock);
+
+		uint16_t handle = keys.find(key);
+		if (handle != bx::kInvalidHandle)
+		{
+			lru.touch(handle);
+
+			// give a failed load another go, in case the file showed up since
+			SampleEntry & entry = entries[handle];
+			if (entry.state.load(std::memory_order_relaxed) == SampleEntry::kFailed && entry.refs.load(std::memory_order_acquire) == 0)
+			{
+				QueueLoad(handle);
+				queued = true;
+			}
+
+			view = SampleView(&entry);
+		}
+		else
+		{
+			handle = lru.alloc();
+			if (handle == bx::kInvalidHandle)
+			{
+				if (!EvictOne(bx::kInvalidHandle))
+					return SampleView();
+				handle = lru.alloc();
+			}
+
+			SampleEntry & entry = entries[handle];
+			entry.key = key;
+			entry.path = path;
+			entry.info = AudioWav::Info();
+			keys.insert(key, handle);
+
+			QueueLoad(handle);
+			queued = true;
+
+			view = SampleView(&entry);
+		}
+	}
+
+	if (queued && jobs)
+		jobs->Submit(LoadJob, this, JobPool::kBackground, &loads);
+	else if (queued)
+		wake.post();
+
+	return view;
+}
@@ -0,0 +1,148 @@
+//
+//  audio_bank.h
+//  audiosample
+//
+
+#ifndef audio_bank_h
+#define audio_bank_h
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <bx/handlealloc.h>
+#include <bx/mutex.h>
+#include <bx/semaphore.h>
+#include <bx/thread.h>
+
+#include "audio_wav.h"
+#include "job_pool.h"
+
+class SampleBank;
+
+// One sample decoded into memory and shared by everyone who asked for it.
+struct SampleEntry
+{
+	enum State
+	{
+		kEmpty,
+		kQueued,
+		kReady,
+		kFailed,
+	};
+
+	uint32_t key = 0;
+	std::string path;
+	AudioWav::Info info;
+
+	// interleaved, info.frames * info.channels long; only valid once
+	// state reads kReady
+	float * samples = nullptr;
+	uint64_t bytes = 0;
+
+	std::atomic<int32_t> state { kEmpty };
+	std::atomic<int32_t> refs { 0 };
+};
+
+// Ref-counted, read-only handle to a bank sample.  Holding one keeps the
+// sample resident; copies are cheap and safe to drop on any thread.
+// Until the worker finishes loading, IsReady is false and GetSamples is
+// null, and players should treat it as silence.
+class SampleView
+{
+	SampleEntry * entry = nullptr;
+
+	friend class SampleBank;
+	explicit SampleView(SampleEntry * entry);
+
+public:
+	SampleView() {}
+	SampleView(const SampleView & other);
+	SampleView & operator = (const SampleView & other);
+	~SampleView();
+
+	bool IsValid() const { return entry != nullptr; }
+	bool IsReady() const { return entry && entry->state.load(std::memory_order_acquire) == SampleEntry::kReady; }
+	bool IsFailed() const { return !entry || entry->state.load(std::memory_order_acquire) == SampleEntry::kFailed; }
+
+	const float * GetSamples() const { return IsReady() ? entry->samples : nullptr; }
+	const AudioWav::Info & GetInfo() const;
+};
+
+// Loads sample assets once, keyed by a hash of their path, and hands out
+// views to any number of players.  Loading happens as background jobs
+// on the app's JobPool, or on a thread of the bank's own if there's no
+// pool with workers to give it.
+// Entries nobody holds stay cached in least recently used order, and the
+// coldest are evicted whenever the decoded total goes over the budget.
+class SampleBank
+{
+public:
+	static const uint16_t kMaxSamples = 512;
+
+	struct Config
+	{
+		// decoded bytes kept resident before cold samples are evicted
+		uint64_t budgetBytes = 256ull << 20;
+	};
+
+private:
+	bx::Thread thread;
+	bx::Semaphore wake;
+	std::atomic<bool> running { false };
+
+	// set when decoding goes through the pool instead of the thread
+	JobPool * jobs = nullptr;
+	JobCounter loads;
+
+	// guards everything below between the game thread and the worker
+	bx::Mutex lock;
+	bx::HandleAllocLruT<kMaxSamples> lru;
+	bx::HandleHashMapT<kMaxSamples * 2> keys;
+	SampleEntry entries[kMaxSamples];
+	std::deque<uint16_t> loadQueue;
+	std::atomic<uint64_t> residentBytes { 0 };
+
+	// queued or mid-decode, for WaitForLoads on the thread path
+	std::atomic<int32_t> pendingLoads { 0 };
+
+	Config config;
+
+	static SampleBank * sInstance;
+
+	static int32_t ThreadFunc(bx::Thread * self, void * userData);
+	void Run();
+	static void LoadJob(void * userData);
+	bool LoadNext();
+	void QueueLoad(uint16_t handle);
+	void Load(SampleEntry & entry);
+	bool EvictOne(uint16_t keep);
+	void Evict(uint16_t handle);
+	void Trim(uint16_t keep);
+
+public:
+	SampleBank();
+	~SampleBank();
+
+	static SampleBank * Instance() { return sInstance; }
+
+	static uint32_t HashPath(const char * path);
+
+	bool Init();
+	bool Init(const Config & config);
+	void Shutdown();
+
+	// game thread; returns the cached sample or queues a load, keyed by
+	// the path's hash unless one is given.  The view is invalid only if
+	// every slot is held.
+	SampleView Acquire(const char * path);
+	SampleView Acquire(uint32_t key, const char * path);
+
+	// blocks until every queued load has landed or failed; for offline
+	// renders, which would otherwise run far ahead of the loads
+	void WaitForLoads();
+
+	uint64_t GetResidentBytes() const { return residentBytes.load(std::memory_order_relaxed); }
+};
+
+#endif /* audio_bank_h */
@@ -0,0 +1,76 @@
+//
+//  audio_buffer.cpp
+//  audiosample
+//
+
+#include "audio_buffer.h"
+
+#include <bx/allocator.h>
+#include <string.h>
+
+static bx::DefaultAllocator sAllocator;
+
+// the largest power of two, up to kAlign, that every one of bits is a
+// multiple of
+static int32_t LowestBit(uintptr_t bits)
+{
+	bits |= uintptr_t(AudioBuffer::kAlign);
+	return int32_t(bits & (~bits + 1));
+}
+
+AudioBuffer::AudioBuffer(float * samples, int32_t numFrames, int32_t numChannels) :
+	data(samples),
+	frames(numFrames),
+	channels(numChannels),
+	layout(kInterleaved),
+	planeStride(0),
+	alignment(LowestBit(uintptr_t(samples)))
+{
+}
+
+AudioBuffer::AudioBuffer(float * samples, int32_t numFrames, int32_t numChannels, int32_t stride) :
+	data(samples),
+	frames(numFrames),
+	channels(numChannels),
+	layout(kPlanar),
+	planeStride(stride),
+	alignment(LowestBit(uintptr_t(samples) | (numChannels > 1 ? uintptr_t(stride) * sizeof(float) : 0)))
+{
+}
+
+AudioBuffer AudioBuffer::Slice(int32_t first, int32_t count) const
+{
+	if (layout == kPlanar)
+		return AudioBuffer(data + first, count, channels, planeStride);
+
+	return AudioBuffer(data + first * channels, count, channels);
+}
+
+AudioBuffer AudioBuffer::SameLayout(float * storage, int32_t numFrames, int32_t capacity) const
+{
+	if (layout == kPlanar)
+		return AudioBuffer(storage, numFrames, channels, GetPlaneStride(capacity));
+
+	return AudioBuffer(storage, numFrames, channels);
+}
+
+int32_t AudioBuffer::GetPlaneStride(int32_t numFrames)
+{
+	const int32_t alignFloats = kAlign / int32_t(sizeof(float));
+	return (numFrames + alignFloats - 1) & ~(alignFloats - 1);
+}
+
+float * AudioBuffer::Allocate(int32_t numFrames, int32_t numChannels)
+{
+	// planar needs every plane padded out; interleaved fits in the same
+	const size_t bytes = size_t(GetPlaneStride(numFrames)) * numChannels * sizeof(float);
+	float * samples = (float *) BX_ALIGNED_ALLOC(&sAllocator, bytes, kAlign);
+	memset(samples, 0, bytes);
+	return samples;
+}
+
+void AudioBuffer::Free(float * samples)
+{
+	if (samples)
+		BX_ALIGNED_FREE(&sAllocator, samples, kAlign);
+}
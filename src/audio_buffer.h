@@ -0,0 +1,81 @@
+//
+//  audio_buffer.h
+//  audiosample
+//
+
+#ifndef audio_buffer_h
+#define audio_buffer_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A view of a block of samples: where they are, how many frames and
+// channels, and how the channels are laid out.  Writers render into one,
+// so none of them has to guess the channel count, and SIMD code can ask
+// how the samples line up instead of assuming.  The view owns nothing;
+// Allocate hands out the storage the engine renders into.
+struct AudioBuffer
+{
+	enum Layout
+	{
+		// a frame's samples side by side, one per channel
+		kInterleaved,
+
+		// each channel's samples side by side, planeStride samples from
+		// one channel's plane to the next
+		kPlanar,
+	};
+
+	// engine buffers, and each plane in them, start on this many bytes:
+	// a cache line, and enough for any SIMD width
+	static const int32_t kAlign = 64;
+
+	float * data = nullptr;
+	int32_t frames = 0;
+	int32_t channels = 1;
+	Layout layout = kInterleaved;
+	int32_t planeStride = 0;
+
+	// bytes data, and every plane, is known to start on, up to kAlign;
+	// worked out from the pointer, so it holds for any view
+	int32_t alignment = 0;
+
+	AudioBuffer() {}
+
+	// interleaved
+	AudioBuffer(float * samples, int32_t numFrames, int32_t numChannels = 1);
+
+	// planar, planes planeStride samples apart
+	AudioBuffer(float * samples, int32_t numFrames, int32_t numChannels, int32_t stride);
+
+	int32_t GetSamples() const { return frames * channels; }
+
+	// where channel's samples start, the samples from one of its frames to
+	// the next, and from one channel's sample of a frame to the next's
+	float * GetChannel(int32_t channel) const { return data + channel * GetChannelStride(); }
+	int32_t GetStep() const { return layout == kPlanar ? 1 : channels; }
+	int32_t GetChannelStride() const { return layout == kPlanar ? planeStride : 1; }
+
+	// every sample in the view is in one run of GetSamples(), so it can
+	// go through the flat AudioMix helpers in one call
+	bool IsContiguous() const { return layout == kInterleaved || channels == 1 || planeStride == frames; }
+
+	bool IsAligned(int32_t bytes) const { return alignment >= bytes; }
+
+	// frames [first, first + count) of the same channels
+	AudioBuffer Slice(int32_t first, int32_t count) const;
+
+	// a view of storage laid out like this one, sized for capacity frames
+	// the way Allocate sizes it
+	AudioBuffer SameLayout(float * storage, int32_t numFrames, int32_t capacity) const;
+
+	// samples between planes for a block of frames, rounded up so each
+	// plane stays on kAlign
+	static int32_t GetPlaneStride(int32_t numFrames);
+
+	// zeroed storage for channels of frames in either layout, on kAlign
+	static float * Allocate(int32_t numFrames, int32_t numChannels);
+	static void Free(float * samples);
+};
+
+#endif /* audio_buffer_h */
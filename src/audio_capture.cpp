@@ -0,0 +1,240 @@
+//
+//  audio_capture.cpp
+//  audiosample
+//
+
+#include "audio_capture.h"
+
+#include <bx/os.h>
+#include <string.h>
+
+// the header is padded out to one page so every chunk after it starts on
+// an aligned file offset; the padding also holds the ds64 chunk RF64
+// needs, which is written as JUNK until we know the file is that big
+static const int32_t kHeaderSize = 4096;
+static const int32_t kDs64Offset = 12;
+static const int32_t kDs64Size = 28;
+static const int32_t kFmtOffset = kDs64Offset + 8 + kDs64Size;
+static const int32_t kFmtSize = 16;
+static const int32_t kPadOffset = kFmtOffset + 8 + kFmtSize;
+static const int32_t kDataOffset = kHeaderSize - 8;
+
+// file writes go out in pieces this big, and the writer pulls this many
+// frames off the ring per conversion
+static const int32_t kChunkBytes = 1 << 20;
+static const int32_t kBatchFrames = 4096;
+
+// how often the writer looks at the ring; polling keeps the audio thread
+// out of any os call, which a semaphore post can't promise
+static const uint32_t kPollMs = 10;
+
+static void Put16(uint8_t * out, uint16_t value)
+{
+	out[0] = uint8_t(value);
+	out[1] = uint8_t(value >> 8);
+}
+
+static void Put32(uint8_t * out, uint32_t value)
+{
+	for (int32_t b = 0; b < 4; b++)
+		out[b] = uint8_t(value >> (8 * b));
+}
+
+static void Put64(uint8_t * out, uint64_t value)
+{
+	for (int32_t b = 0; b < 8; b++)
+		out[b] = uint8_t(value >> (8 * b));
+}
+
+int32_t AudioCapture::ThreadFunc(bx::Thread * self, void * userData)
+{
+	((AudioCapture *) userData)->Run();
+	return 0;
+}
+
+void AudioCapture::Run()
+{
+	while (running.load(std::memory_order_acquire))
+	{
+		Drain(false);
+		bx::sleep(kPollMs);
+	}
+
+	// Close has stopped the producer, so this picks up the last of it
+	Drain(true);
+}
+
+void AudioCapture::Drain(bool flush)
+{
+	const int32_t bytesPerSample = AudioWav::BytesPerSample(format);
+	const uint32_t batchSamples = uint32_t(kBatchFrames * channels);
+
+	uint32_t available;
+	while ((available = ring.GetAvailable()) > 0)
+	{
+		const uint32_t numSamples = ring.Read(floatStage, available < batchSamples ? available : batchSamples);
+
+		// after a write error keep emptying the ring so the audio thread
+		// doesn't start dropping, but stop touching the file
+		if (GetError())
+			continue;
+
+		AudioWav::Encode(floatStage, int32_t(numSamples), format, byteStage + stagedBytes);
+		stagedBytes += int32_t(numSamples) * bytesPerSample;
+		framesWritten.fetch_add(numSamples / channels, std::memory_order_relaxed);
+
+		while (stagedBytes >= kChunkBytes)
+		{
+			WriteChunk(byteStage, kChunkBytes);
+			stagedBytes -= kChunkBytes;
+			memmove(byteStage, byteStage + kChunkBytes, stagedBytes);
+		}
+	}
+
+	if (flush && stagedBytes > 0)
+	{
+		WriteChunk(byteStage, stagedBytes);
+		stagedBytes = 0;
+	}
+}
+
+void AudioCapture::WriteChunk(const void * data, int32_t size)
+{
+	if (GetError())
+		return;
+
+	bx::Error err;
+	const int32_t written = file.write(data, size, &err);
+	bytesWritten += written > 0 ? written : 0;
+
+	if (!err.isOk() || written != size)
+		error.store("capture couldn't keep writing to disk", std::memory_order_relaxed);
+}
+
+void AudioCapture::WriteHeader()
+{
+	const int32_t bytesPerSample = AudioWav::BytesPerSample(format);
+	const uint16_t blockAlign = uint16_t(channels * bytesPerSample);
+	const uint64_t dataBytes = bytesWritten;
+
+	// chunks are word aligned, so an odd data chunk gets a pad byte that
+	// counts toward the RIFF size but not the data size
+	const uint64_t paddedBytes = dataBytes + (dataBytes & 1);
+	const uint64_t riffBytes = kHeaderSize - 8 + paddedBytes;
+	const bool rf64 = riffBytes > 0xffffffffull;
+
+	uint8_t header[kHeaderSize];
+	memset(header, 0, sizeof(header));
+
+	memcpy(header + 0, rf64 ? "RF64" : "RIFF", 4);
+	Put32(header + 4, rf64 ? 0xffffffffu : uint32_t(riffBytes));
+	memcpy(header + 8, "WAVE", 4);
+
+	memcpy(header + kDs64Offset, rf64 ? "ds64" : "JUNK", 4);
+	Put32(header + kDs64Offset + 4, kDs64Size);
+	if (rf64)
+	{
+		Put64(header + kDs64Offset + 8, riffBytes);
+		Put64(header + kDs64Offset + 16, dataBytes);
+		Put64(header + kDs64Offset + 24, dataBytes / blockAlign);
+	}
+
+	memcpy(header + kFmtOffset, "fmt ", 4);
+	Put32(header + kFmtOffset + 4, kFmtSize);
+	Put16(header + kFmtOffset + 8, AudioWav::FormatTag(format));
+	Put16(header + kFmtOffset + 10, uint16_t(channels));
+	Put32(header + kFmtOffset + 12, uint32_t(hertz));
+	Put32(header + kFmtOffset + 16, uint32_t(hertz) * blockAlign);
+	Put16(header + kFmtOffset + 20, blockAlign);
+	Put16(header + kFmtOffset + 22, uint16_t(bytesPerSample * 8));
+
+	memcpy(header + kPadOffset, "JUNK", 4);
+	Put32(header + kPadOffset + 4, kDataOffset - kPadOffset - 8);
+
+	memcpy(header + kDataOffset, "data", 4);
+	Put32(header + kDataOffset + 4, rf64 ? 0xffffffffu : uint32_t(dataBytes));
+
+	bx::Error err;
+	file.write(header, kHeaderSize, &err);
+}
+
+bool AudioCapture::Open(const char * path, int32_t openHertz, int32_t openChannels, AudioWav::SampleFormat openFormat, float bufferSeconds)
+{
+	Close();
+
+	error.store(nullptr, std::memory_order_relaxed);
+
+	bx::Error err;
+	if (!file.open(bx::FilePath(path), false, &err))
+	{
+		error.store("capture couldn't open its file", std::memory_order_relaxed);
+		return false;
+	}
+
+	hertz = openHertz;
+	channels = openChannels;
+	format = openFormat;
+	framesWritten.store(0, std::memory_order_relaxed);
+	framesDropped.store(0, std::memory_order_relaxed);
+	bytesWritten = 0;
+	stagedBytes = 0;
+
+	ring.Init(uint32_t(bufferSeconds * hertz) * channels);
+
+	const int32_t batchSamples = kBatchFrames * channels;
+	floatStage = (float *) BX_ALIGNED_ALLOC(&allocator, batchSamples * sizeof(float), 16);
+	byteStage = (uint8_t *) BX_ALIGNED_ALLOC(&allocator, kChunkBytes + batchSamples * sizeof(float), 4096);
+
+	// sizes stay zero until Close, so a crashed session still leaves a
+	// file that tools recognize
+	WriteHeader();
+
+	isOpen = true;
+	running.store(true, std::memory_order_release);
+	if (!thread.init(ThreadFunc, this, 0, "audio capture"))
+	{
+		running.store(false, std::memory_order_release);
+		error.store("capture couldn't start its thread", std::memory_order_relaxed);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool AudioCapture::Push(const float * buffer, int32_t numFrames)
+{
+	if (ring.Write(buffer, uint32_t(numFrames * channels)))
+		return true;
+
+	framesDropped.fetch_add(numFrames, std::memory_order_relaxed);
+	return false;
+}
+
+void AudioCapture::Close()
+{
+	if (!isOpen)
+		return;
+
+	if (running.exchange(false))
+		thread.shutdown();
+
+	// the data chunk has to end on a word boundary
+	if (bytesWritten & 1)
+	{
+		const uint8_t pad = 0;
+		bx::Error err;
+		file.write(&pad, 1, &err);
+	}
+
+	file.seek(0, bx::Whence::Begin);
+	WriteHeader();
+	file.close();
+
+	BX_ALIGNED_FREE(&allocator, floatStage, 16);
+	BX_ALIGNED_FREE(&allocator, byteStage, 4096);
+	floatStage = nullptr;
+	byteStage = nullptr;
+
+	isOpen = false;
+}
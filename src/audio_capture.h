@@ -0,0 +1,84 @@
+//
+//  audio_capture.h
+//  audiosample
+//
+
+#ifndef audio_capture_h
+#define audio_capture_h
+
+#include <stdint.h>
+#include <atomic>
+#include <bx/allocator.h>
+#include <bx/file.h>
+#include <bx/thread.h>
+
+#include "audio_ring.h"
+#include "audio_wav.h"
+
+// Streams the mix to a wav file for long sessions.  The audio thread
+// hands blocks over through a lock-free ring and goes straight back to
+// mixing; a writer thread converts them to the output format and writes
+// them in large chunks that land on aligned file offsets.  If the disk
+// falls far enough behind that the ring fills, blocks are dropped and
+// counted rather than ever making the audio thread wait.
+//
+// Files that outgrow the 4GB RIFF limit are finished as RF64, using the
+// space reserved for it at the front of the header.
+class AudioCapture
+{
+	bx::Thread thread;
+	bx::FileWriter file;
+	bx::DefaultAllocator allocator;
+
+	// audio thread to writer thread
+	AudioRing ring;
+
+	// writer thread staging: floats pulled off the ring, and the encoded
+	// bytes waiting to make up a full chunk
+	float * floatStage = nullptr;
+	uint8_t * byteStage = nullptr;
+	int32_t stagedBytes = 0;
+
+	int32_t hertz = 0;
+	int32_t channels = 0;
+	AudioWav::SampleFormat format = AudioWav::kFloat32;
+
+	std::atomic<bool> running { false };
+	std::atomic<uint64_t> framesWritten { 0 };
+	std::atomic<uint64_t> framesDropped { 0 };
+	uint64_t bytesWritten = 0;
+
+	std::atomic<const char *> error { nullptr };
+	bool isOpen = false;
+
+	static int32_t ThreadFunc(bx::Thread * self, void * userData);
+	void Run();
+	void Drain(bool flush);
+	void WriteChunk(const void * data, int32_t size);
+	void WriteHeader();
+
+public:
+	AudioCapture() {}
+	AudioCapture(const AudioCapture &) = delete;
+	AudioCapture & operator = (const AudioCapture &) = delete;
+
+	~AudioCapture() { Close(); }
+
+	// bufferSeconds is how far the disk can fall behind before blocks
+	// start getting dropped
+	bool Open(const char * path, int32_t hertz, int32_t channels, AudioWav::SampleFormat format, float bufferSeconds = 2.0f);
+
+	// audio thread: never blocks or allocates; returns false if the
+	// block had to be dropped
+	bool Push(const float * buffer, int32_t numFrames);
+
+	// flushes whatever is still queued and finishes the header
+	void Close();
+
+	bool IsOpen() const { return isOpen; }
+	uint64_t GetFramesWritten() const { return framesWritten.load(std::memory_order_relaxed); }
+	uint64_t GetFramesDropped() const { return framesDropped.load(std::memory_order_relaxed); }
+	const char * GetError() const { return error.load(std::memory_order_relaxed); }
+};
+
+#endif /* audio_capture_h */
@@ -0,0 +1,151 @@
+//
+//  audio_commands.h
+//  audiosample
+//
+
+#ifndef audio_commands_h
+#define audio_commands_h
+
+#include <stdint.h>
+
+namespace AudioWriter
+{
+	struct Base;
+	struct Instrument;
+}
+
+struct AudioStream;
+
+// Something game code wants the mixer to do.  Commands go through the
+// AudioSubmodule's queue and are applied on the audio thread between
+// renders, so nothing the mixer reads is ever written from another
+// thread mid-block.
+//
+// frame is a time on the mixer clock (AudioSubmodule::GetMixFrame); the
+// block containing it is split there, so the change lands on exactly
+// that sample.  0, or a frame already mixed, means the next block start.
+//
+// SetParam steps a value; RampParam glides to it over rampFrames, which
+// needs the writer to have been Automate'd before it started playing.
+// Without automation a ramp lands as a step.  A writer whose gain has
+// been set this way is never retired for going quiet, since it may be
+// turned back up.
+//
+// SetPan moves a stream across the bus's channels, value running from -1
+// left to 1 right.
+//
+// PlayNote starts a note on an Instrument's voices, value being its pitch,
+// so a live part needs one stream rather than a new tree per note.
+struct AudioCommand
+{
+	enum Type
+	{
+		kStart,
+		kStop,
+		kSetVolume,
+		kSetPan,
+		kSetParam,
+		kRampParam,
+		kPlayNote,
+	};
+
+	enum Param
+	{
+		kGain,
+		kPitch,
+		kPhase,
+	};
+
+	Type type = kStart;
+	Param param = kGain;
+	float value = 0.0f;
+	int32_t rampFrames = 0;
+	uint64_t frame = 0;
+
+	// the note's, besides its pitch
+	float gain = 0.0f;
+	float duration = 0.0f;
+
+	AudioStream * stream = nullptr;
+	AudioWriter::Base * writer = nullptr;
+	AudioWriter::Instrument * instrument = nullptr;
+
+	// set by Post; commands from before DestroyAudioStreams are dropped
+	uint32_t generation = 0;
+
+	static AudioCommand Start(AudioStream * stream, uint64_t frame = 0);
+	static AudioCommand Stop(AudioStream * stream, uint64_t frame = 0);
+	static AudioCommand SetVolume(AudioStream * stream, float volume, uint64_t frame = 0);
+	static AudioCommand SetPan(AudioStream * stream, float pan, uint64_t frame = 0);
+	static AudioCommand SetParam(AudioWriter::Base * writer, Param param, float value, uint64_t frame = 0);
+	static AudioCommand RampParam(AudioWriter::Base * writer, Param param, float value, int32_t rampFrames, uint64_t frame = 0);
+	static AudioCommand PlayNote(AudioWriter::Instrument * instrument, float pitch, float gain, float duration, uint64_t frame = 0);
+};
+
+inline AudioCommand AudioCommand::Start(AudioStream * stream, uint64_t frame)
+{
+	AudioCommand command;
+	command.type = kStart;
+	command.stream = stream;
+	command.frame = frame;
+	return command;
+}
+
+inline AudioCommand AudioCommand::Stop(AudioStream * stream, uint64_t frame)
+{
+	AudioCommand command;
+	command.type = kStop;
+	command.stream = stream;
+	command.frame = frame;
+	return command;
+}
+
+inline AudioCommand AudioCommand::SetVolume(AudioStream * stream, float volume, uint64_t frame)
+{
+	AudioCommand command;
+	command.type = kSetVolume;
+	command.stream = stream;
+	command.value = volume;
+	command.frame = frame;
+	return command;
+}
+
+inline AudioCommand AudioCommand::SetPan(AudioStream * stream, float pan, uint64_t frame)
+{
+	AudioCommand command = SetVolume(stream, pan, frame);
+	command.type = kSetPan;
+	return command;
+}
+
+inline AudioCommand AudioCommand::SetParam(AudioWriter::Base * writer, Param param, float value, uint64_t frame)
+{
+	AudioCommand command;
+	command.type = kSetParam;
+	command.writer = writer;
+	command.param = param;
+	command.value = value;
+	command.frame = frame;
+	return command;
+}
+
+inline AudioCommand AudioCommand::RampParam(AudioWriter::Base * writer, Param param, float value, int32_t rampFrames, uint64_t frame)
+{
+	AudioCommand command = SetParam(writer, param, value, frame);
+	command.type = kRampParam;
+	command.rampFrames = rampFrames;
+	return command;
+}
+
+inline AudioCommand AudioCommand::PlayNote(AudioWriter::Instrument * instrument, float pitch, float gain, float duration, uint64_t frame)
+{
+	AudioCommand command;
+	command.type = kPlayNote;
+	command.instrument = instrument;
+	command.value = pitch;
+	command.gain = gain;
+	command.duration = duration;
+	command.frame = frame;
+	return command;
+}
+
+#endif /* audio_commands_h */
@@ -0,0 +1,70 @@
+//
+//  audio_lod.cpp
+//  audiosample
+//
+
+#include "audio_lod.h"
+
+// room for a burst of transitions between two game frames
+static const uint32_t kTransitionCapacity = 64;
+
+void LodGovernor::Init()
+{
+	Init(Config());
+}
+
+void LodGovernor::Init(const Config & initConfig)
+{
+	config = initConfig;
+
+	lod.store(0, std::memory_order_relaxed);
+	hotBlocks = 0;
+	coolBlocks = 0;
+
+	transitions.Init(kTransitionCapacity);
+	history.clear();
+}
+
+int32_t LodGovernor::Update(float load, uint64_t frame)
+{
+	const int32_t current = lod.load(std::memory_order_relaxed);
+
+	hotBlocks = load > config.raiseLoad ? hotBlocks + 1 : 0;
+	coolBlocks = load < config.lowerLoad ? coolBlocks + 1 : 0;
+
+	int32_t next = current;
+	if (hotBlocks >= config.raiseBlocks && current < config.maxLod)
+		next = current + 1;
+	else if (coolBlocks >= config.lowerBlocks && current > 0)
+		next = current - 1;
+
+	if (next != current)
+	{
+		// a fresh count at the new tier, so one change isn't followed by
+		// another before the new tier has had a chance to show its cost
+		hotBlocks = 0;
+		coolBlocks = 0;
+		lod.store(next, std::memory_order_relaxed);
+
+		// a full queue only loses history, never the change itself
+		LodTransition transition;
+		transition.frame = frame;
+		transition.from = current;
+		transition.to = next;
+		transition.load = load;
+		transitions.Push(transition);
+	}
+
+	return next;
+}
+
+void LodGovernor::Collect()
+{
+	LodTransition transition;
+	while (transitions.Pop(transition))
+	{
+		history.push_back(transition);
+		while (int32_t(history.size()) > config.historyLength)
+			history.pop_front();
+	}
+}
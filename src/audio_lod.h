@@ -0,0 +1,80 @@
+//
+//  audio_lod.h
+//  audiosample
+//
+
+#ifndef audio_lod_h
+#define audio_lod_h
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+
+#include "audio_queue.h"
+
+// One change of the mixer's level of detail, for tuning the governor.
+struct LodTransition
+{
+	// mix clock at the block that tipped it
+	uint64_t frame = 0;
+	int32_t from = 0;
+	int32_t to = 0;
+
+	// that block's cost over its duration
+	float load = 0.0f;
+};
+
+// Picks the level of detail the writers render at from how long each
+// mixed block took against how long it lasts.  Detail drops a tier as
+// soon as a few blocks in a row run hot, and only comes back a tier
+// after a long run of cool ones, so it doesn't flap on a noisy load; the
+// gap between the two thresholds is the rest of the hysteresis.  Losing
+// quality beats missing the deadline.
+class LodGovernor
+{
+public:
+	struct Config
+	{
+		// 0 keeps full detail whatever the load
+		int32_t maxLod = 3;
+
+		// a tier coarser after raiseBlocks blocks over raiseLoad in a row
+		float raiseLoad = 0.7f;
+		int32_t raiseBlocks = 2;
+
+		// a tier finer after lowerBlocks blocks under lowerLoad in a row
+		float lowerLoad = 0.35f;
+		int32_t lowerBlocks = 200;
+
+		// transitions kept for GetHistory
+		int32_t historyLength = 64;
+	};
+
+private:
+	Config config;
+
+	std::atomic<int32_t> lod { 0 };
+	int32_t hotBlocks = 0;
+	int32_t coolBlocks = 0;
+
+	// transitions on their way from the audio thread to the game thread
+	AudioQueue<LodTransition> transitions;
+	std::deque<LodTransition> history;
+
+public:
+	void Init();
+	void Init(const Config & config);
+
+	// audio thread, once per mixed block; returns the lod for the next
+	int32_t Update(float load, uint64_t frame);
+
+	int32_t GetLod() const { return lod.load(std::memory_order_relaxed); }
+
+	// game thread; pulls in what changed since the last call
+	void Collect();
+
+	// game thread, oldest first, as of the last Collect
+	const std::deque<LodTransition> & GetHistory() const { return history; }
+};
+
+#endif /* audio_lod_h */
@@ -0,0 +1,452 @@
+//
+//  audio_mix.cpp
+//  audiosample
+//
+
+#include "audio_mix.h"
+
+#include <bx/math.h>
+#include <bx/simd_t.h>
+#include <math.h>
+
+namespace AudioMix
+{
+
+static const uintptr_t kSimdAlign = 16;
+static const int32_t kSimdWidth = 4;
+
+static inline bool IsAligned(const void * ptr)
+{
+	return (uintptr_t(ptr) & (kSimdAlign - 1)) == 0;
+}
+
+// number of samples to step one at a time before dst lands on a
+// simd boundary; clamped to the block so tiny blocks stay scalar
+static inline int32_t HeadLength(const float * dst, int32_t numSamples)
+{
+	int32_t head = 0;
+	while (head < numSamples && !IsAligned(dst + head))
+		head++;
+	return head;
+}
+
+void Zero(float * dst, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] = 0.0f;
+
+	const bx::simd128_t zero = bx::simd_zero();
+	for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		bx::simd_st(dst + c, zero);
+
+	for ( ; c < numSamples; c++)
+		dst[c] = 0.0f;
+}
+
+void Add(float * dst, const float * src, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] += src[c];
+
+	// if src and dst disagree on alignment there is no shared simd
+	// boundary, so just finish the block with the scalar loop
+	if (IsAligned(src + c))
+	{
+		for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		{
+			const bx::simd128_t a = bx::simd_ld(dst + c);
+			const bx::simd128_t b = bx::simd_ld(src + c);
+			bx::simd_st(dst + c, bx::simd_add(a, b));
+		}
+	}
+
+	for ( ; c < numSamples; c++)
+		dst[c] += src[c];
+}
+
+void AddScaled(float * dst, const float * src, float gain, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] += src[c] * gain;
+
+	if (IsAligned(src + c))
+	{
+		const bx::simd128_t g = bx::simd_splat(gain);
+		for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		{
+			const bx::simd128_t a = bx::simd_ld(dst + c);
+			const bx::simd128_t b = bx::simd_ld(src + c);
+			bx::simd_st(dst + c, bx::simd_madd(b, g, a));
+		}
+	}
+
+	for ( ; c < numSamples; c++)
+		dst[c] += src[c] * gain;
+}
+
+void Scale(float * dst, float gain, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] *= gain;
+
+	const bx::simd128_t g = bx::simd_splat(gain);
+	for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		bx::simd_st(dst + c, bx::simd_mul(bx::simd_ld(dst + c), g));
+
+	for ( ; c < numSamples; c++)
+		dst[c] *= gain;
+}
+
+void Multiply(float * dst, const float * src, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] *= src[c];
+
+	if (IsAligned(src + c))
+	{
+		for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		{
+			const bx::simd128_t a = bx::simd_ld(dst + c);
+			const bx::simd128_t b = bx::simd_ld(src + c);
+			bx::simd_st(dst + c, bx::simd_mul(a, b));
+		}
+	}
+
+	for ( ; c < numSamples; c++)
+		dst[c] *= src[c];
+}
+
+void Ramp(float * dst, float start, float step, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] = start + step * float(c);
+
+	// each lane is computed from its own index rather than by adding
+	// step over and over, so long ramps land exactly on their target
+	const bx::simd128_t s = bx::simd_splat(step);
+	const bx::simd128_t base = bx::simd_splat(start);
+	const bx::simd128_t four = bx::simd_splat(float(kSimdWidth));
+	bx::simd128_t index = bx::simd_ld<bx::simd128_t>(float(c), float(c + 1), float(c + 2), float(c + 3));
+	for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+	{
+		bx::simd_st(dst + c, bx::simd_madd(index, s, base));
+		index = bx::simd_add(index, four);
+	}
+
+	for ( ; c < numSamples; c++)
+		dst[c] = start + step * float(c);
+}
+
+void MultiplyRamp(float * dst, float start, float step, int32_t numSamples)
+{
+	const int32_t head = HeadLength(dst, numSamples);
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		dst[c] *= start + step * float(c);
+
+	const bx::simd128_t s = bx::simd_splat(step);
+	const bx::simd128_t base = bx::simd_splat(start);
+	const bx::simd128_t four = bx::simd_splat(float(kSimdWidth));
+	bx::simd128_t index = bx::simd_ld<bx::simd128_t>(float(c), float(c + 1), float(c + 2), float(c + 3));
+	for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+	{
+		const bx::simd128_t ramp = bx::simd_madd(index, s, base);
+		bx::simd_st(dst + c, bx::simd_mul(bx::simd_ld(dst + c), ramp));
+		index = bx::simd_add(index, four);
+	}
+
+	for ( ; c < numSamples; c++)
+		dst[c] *= start + step * float(c);
+}
+
+float Peak(const float * src, int32_t numSamples)
+{
+	const int32_t head = HeadLength(src, numSamples);
+	float peak = 0.0f;
+	int32_t c = 0;
+	for ( ; c < head; c++)
+		peak = fabsf(src[c]) > peak ? fabsf(src[c]) : peak;
+
+	bx::simd128_t lanes = bx::simd_zero();
+	for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		lanes = bx::simd_max(lanes, bx::simd_abs(bx::simd_ld(src + c)));
+
+	BX_ALIGN_DECL_16(float lane[kSimdWidth]);
+	bx::simd_st(lane, lanes);
+	for (float value : lane)
+		peak = value > peak ? value : peak;
+
+	for ( ; c < numSamples; c++)
+		peak = fabsf(src[c]) > peak ? fabsf(src[c]) : peak;
+
+	return peak;
+}
+
+// the two views order their samples alike, so both can be walked as one
+// flat run
+static bool IsSameRun(const AudioBuffer & a, const AudioBuffer & b)
+{
+	return a.IsContiguous() && b.IsContiguous() && (a.channels == 1 || a.layout == b.layout);
+}
+
+void Zero(const AudioBuffer & dst)
+{
+	if (dst.IsContiguous())
+	{
+		Zero(dst.data, dst.GetSamples());
+		return;
+	}
+
+	for (int32_t channel = 0; channel < dst.channels; channel++)
+		Zero(dst.GetChannel(channel), dst.frames);
+}
+
+void Add(const AudioBuffer & dst, const AudioBuffer & src)
+{
+	AddScaled(dst, src, 1.0f);
+}
+
+static inline void AddVector(float * out, bx::simd128_t value, bx::simd128_t gain)
+{
+	bx::simd_st(out, bx::simd_madd(value, gain, bx::simd_ld(out)));
+}
+
+static void AddStrided(const AudioBuffer & dst, const AudioBuffer & src, float gain, int32_t begin, int32_t end)
+{
+	const int32_t dstStep = dst.GetStep();
+	const int32_t srcStep = src.GetStep();
+	for (int32_t channel = 0; channel < dst.channels; channel++)
+	{
+		float * out = dst.GetChannel(channel);
+		const float * in = src.GetChannel(channel);
+		for (int32_t frame = begin; frame < end; frame++)
+			out[frame * dstStep] += in[frame * srcStep] * gain;
+	}
+}
+
+// planar src into interleaved dst four frames at a time: each group of
+// channel vectors is transposed into frames with shuffles, so the planes
+// are read and dst written once, on simd boundaries
+static void AddInterleaved(const AudioBuffer & dst, const AudioBuffer & src, float gain)
+{
+	const int32_t channels = dst.channels;
+
+	// one frame at a time until the planes and dst line up; if they never
+	// do it's scalar the whole way
+	int32_t frame = 0;
+	while (frame < kSimdWidth && frame < dst.frames && !(IsAligned(dst.data + frame * channels) && src.Slice(frame, 0).IsAligned(int32_t(kSimdAlign))))
+		frame++;
+
+	if (frame == kSimdWidth || frame == dst.frames)
+	{
+		AddStrided(dst, src, gain, 0, dst.frames);
+		return;
+	}
+
+	AddStrided(dst, src, gain, 0, frame);
+
+	const bx::simd128_t g = bx::simd_splat(gain);
+	const float * c0 = src.GetChannel(0);
+	const float * c1 = src.GetChannel(1);
+	for ( ; frame + kSimdWidth <= dst.frames; frame += kSimdWidth)
+	{
+		float * out = dst.data + frame * channels;
+		const bx::simd128_t a = bx::simd_ld(c0 + frame);
+		const bx::simd128_t b = bx::simd_ld(c1 + frame);
+
+		// L0 R0 L1 R1 and L2 R2 L3 R3
+		const bx::simd128_t p0 = bx::simd_shuf_xAyB(a, b);
+		const bx::simd128_t q0 = bx::simd_shuf_zCwD(a, b);
+		if (channels == 2)
+		{
+			AddVector(out, p0, g);
+			AddVector(out + 4, q0, g);
+			continue;
+		}
+
+		const bx::simd128_t c = bx::simd_ld(src.GetChannel(2) + frame);
+		const bx::simd128_t d = bx::simd_ld(src.GetChannel(3) + frame);
+		const bx::simd128_t p1 = bx::simd_shuf_xAyB(c, d);
+		const bx::simd128_t q1 = bx::simd_shuf_zCwD(c, d);
+		if (channels == 4)
+		{
+			AddVector(out, bx::simd_shuf_xyAB(p0, p1), g);
+			AddVector(out + 4, bx::simd_shuf_zwCD(p0, p1), g);
+			AddVector(out + 8, bx::simd_shuf_xyAB(q0, q1), g);
+			AddVector(out + 12, bx::simd_shuf_zwCD(q0, q1), g);
+			continue;
+		}
+
+		// six channels make four frames six vectors, two pairs to a vector
+		const bx::simd128_t e = bx::simd_ld(src.GetChannel(4) + frame);
+		const bx::simd128_t f = bx::simd_ld(src.GetChannel(5) + frame);
+		const bx::simd128_t p2 = bx::simd_shuf_xAyB(e, f);
+		const bx::simd128_t q2 = bx::simd_shuf_zCwD(e, f);
+		AddVector(out, bx::simd_shuf_xyAB(p0, p1), g);
+		AddVector(out + 4, bx::simd_shuf_xyAB(p2, bx::simd_swiz_zwzw(p0)), g);
+		AddVector(out + 8, bx::simd_shuf_zwCD(p1, p2), g);
+		AddVector(out + 12, bx::simd_shuf_xyAB(q0, q1), g);
+		AddVector(out + 16, bx::simd_shuf_xyAB(q2, bx::simd_swiz_zwzw(q0)), g);
+		AddVector(out + 20, bx::simd_shuf_zwCD(q1, q2), g);
+	}
+
+	AddStrided(dst, src, gain, frame, dst.frames);
+}
+
+void AddScaled(const AudioBuffer & dst, const AudioBuffer & src, float gain)
+{
+	// a gain of one goes through Add, a multiply cheaper
+	if (IsSameRun(dst, src))
+	{
+		if (gain == 1.0f)
+			Add(dst.data, src.data, dst.GetSamples());
+		else
+			AddScaled(dst.data, src.data, gain, dst.GetSamples());
+		return;
+	}
+
+	const int32_t dstStep = dst.GetStep();
+	const int32_t srcStep = src.GetStep();
+	if (dstStep != 1 && srcStep == 1 && (dst.channels == 2 || dst.channels == 4 || dst.channels == 6))
+	{
+		AddInterleaved(dst, src, gain);
+		return;
+	}
+
+	if (dstStep != 1 || srcStep != 1)
+	{
+		AddStrided(dst, src, gain, 0, dst.frames);
+		return;
+	}
+
+	for (int32_t channel = 0; channel < dst.channels; channel++)
+	{
+		if (gain == 1.0f)
+			Add(dst.GetChannel(channel), src.GetChannel(channel), dst.frames);
+		else
+			AddScaled(dst.GetChannel(channel), src.GetChannel(channel), gain, dst.frames);
+	}
+}
+
+void Multiply(const AudioBuffer & dst, const float * curve)
+{
+	if (dst.channels == 1 || dst.layout == AudioBuffer::kPlanar)
+	{
+		for (int32_t channel = 0; channel < dst.channels; channel++)
+			Multiply(dst.GetChannel(channel), curve, dst.frames);
+		return;
+	}
+
+	for (int32_t frame = 0; frame < dst.frames; frame++)
+	{
+		float * out = dst.data + frame * dst.channels;
+		for (int32_t channel = 0; channel < dst.channels; channel++)
+			out[channel] *= curve[frame];
+	}
+}
+
+void MultiplyRamp(const AudioBuffer & dst, float start, float step)
+{
+	if (dst.channels == 1 || dst.layout == AudioBuffer::kPlanar)
+	{
+		for (int32_t channel = 0; channel < dst.channels; channel++)
+			MultiplyRamp(dst.GetChannel(channel), start, step, dst.frames);
+		return;
+	}
+
+	for (int32_t frame = 0; frame < dst.frames; frame++)
+	{
+		const float value = start + step * float(frame);
+		float * out = dst.data + frame * dst.channels;
+		for (int32_t channel = 0; channel < dst.channels; channel++)
+			out[channel] *= value;
+	}
+}
+
+float Peak(const AudioBuffer & src)
+{
+	if (src.IsContiguous())
+		return Peak(src.data, src.GetSamples());
+
+	float peak = 0.0f;
+	for (int32_t channel = 0; channel < src.channels; channel++)
+	{
+		const float channelPeak = Peak(src.GetChannel(channel), src.frames);
+		peak = channelPeak > peak ? channelPeak : peak;
+	}
+
+	return peak;
+}
+
+// constant power between two channels, position 0 all first to 1 all
+// second; the ends are exact, so the silent side is skipped
+static void PanPair(float position, float & first, float & second)
+{
+	if (position <= 0.0f || position >= 1.0f)
+	{
+		first = position <= 0.0f ? 1.0f : 0.0f;
+		second = 1.0f - first;
+		return;
+	}
+
+	first = cosf(position * bx::kPiHalf);
+	second = sinf(position * bx::kPiHalf);
+}
+
+void PanGains(float pan, int32_t channels, float * gains)
+{
+	for (int32_t channel = 0; channel < channels; channel++)
+		gains[channel] = 0.0f;
+
+	if (channels == 1)
+	{
+		gains[0] = 1.0f;
+		return;
+	}
+
+	// 5.1 pans left to center, then center to right
+	if (channels == 6)
+	{
+		if (pan <= 0.0f)
+			PanPair(pan + 1.0f, gains[0], gains[2]);
+		else
+			PanPair(pan, gains[2], gains[1]);
+		return;
+	}
+
+	PanPair((pan + 1.0f) * 0.5f, gains[0], gains[1]);
+}
+
+void AddPanned(const AudioBuffer & dst, const AudioBuffer & src, const float * gains)
+{
+	const int32_t step = dst.GetStep();
+	for (int32_t channel = 0; channel < dst.channels; channel++)
+	{
+		if (gains[channel] == 0.0f)
+			continue;
+
+		float * out = dst.GetChannel(channel);
+		if (step == 1)
+		{
+			AddScaled(out, src.data, gains[channel], dst.frames);
+			continue;
+		}
+
+		for (int32_t frame = 0; frame < dst.frames; frame++)
+			out[frame * step] += src.data[frame] * gains[channel];
+	}
+}
+
+}
@@ -0,0 +1,73 @@
+//
+//  audio_mix.h
+//  audiosample
+//
+
+#ifndef audio_mix_h
+#define audio_mix_h
+
+#include <stdint.h>
+
+#include "audio_buffer.h"
+
+// Block level mixing helpers used by the mixer bus and the writers.
+// The bulk of each block goes through bx's 128 bit SIMD; any unaligned
+// head or tail is handled one sample at a time, so callers can pass
+// buffers straight from the backend without worrying about alignment.
+namespace AudioMix
+{
+
+// dst[i] = 0
+void Zero(float * dst, int32_t numSamples);
+
+// dst[i] += src[i]
+void Add(float * dst, const float * src, int32_t numSamples);
+
+// dst[i] += src[i] * gain
+void AddScaled(float * dst, const float * src, float gain, int32_t numSamples);
+
+// dst[i] *= gain
+void Scale(float * dst, float gain, int32_t numSamples);
+
+// dst[i] *= src[i]
+void Multiply(float * dst, const float * src, int32_t numSamples);
+
+// dst[i] = start + step * i, for per sample parameter curves
+void Ramp(float * dst, float start, float step, int32_t numSamples);
+
+// dst[i] *= start + step * i, for control rate values spread over a block
+void MultiplyRamp(float * dst, float start, float step, int32_t numSamples);
+
+// the largest |src[i]|, for level tracking
+float Peak(const float * src, int32_t numSamples);
+
+// The same over every channel of a view.  dst and src have the same
+// frames and channels but either can be interleaved or planar; matching
+// layouts go through the SIMD paths above in as few runs as they can.
+// Planar into interleaved, the bus handing its block to the backend, is
+// one SIMD interleaving pass for 2, 4 and 6 channels.
+void Zero(const AudioBuffer & dst);
+void Add(const AudioBuffer & dst, const AudioBuffer & src);
+void AddScaled(const AudioBuffer & dst, const AudioBuffer & src, float gain);
+
+// one value per frame, scaling every channel of that frame alike
+void Multiply(const AudioBuffer & dst, const float * curve);
+void MultiplyRamp(const AudioBuffer & dst, float start, float step);
+
+float Peak(const AudioBuffer & src);
+
+// most output channels a voice can be panned over
+static const int32_t kMaxChannels = 8;
+
+// constant power gains for a mono voice at pan, -1 left to 1 right, over
+// channels laid out the way devices order them: mono, L R, L R Ls Rs, or
+// L R C LFE Ls Rs, where the front three share the pan.  Any other count
+// pans over its first two
+void PanGains(float pan, int32_t channels, float * gains);
+
+// dst channel c += mono src * gains[c]; a channel with no gain is skipped
+void AddPanned(const AudioBuffer & dst, const AudioBuffer & src, const float * gains);
+
+}
+
+#endif /* audio_mix_h */
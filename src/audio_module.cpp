@@ -7,32 +7,46 @@
 
 #include "audio_module.h"
 
-//#include <fmod/fmod.hpp>
-#include <fmod/fmod_errors.h>
-#include <fmod/fmod.hpp>
 #include <stdio.h>
 #include <stdlib.h>
-#include "presentation_modules.h"
+#include <algorithm>
+#include <bx/os.h>
+#include <bx/timer.h>
+#include "audio_mix.h"
 
 #define StackAlloc alloca
 
 AudioSubmodule * AudioSubmodule::sInstance;
 
-void PostFMODError(FMOD_RESULT result)
-{
-	DebugSubmodule::Instance()->SetDebugString(FMOD_ErrorString(result));
-}
-
 AudioSubmodule::AudioSubmodule()
 {
 	BX_ASSERT(sInstance == nullptr);
 	sInstance = this;
+	
+	for (auto & ticks : workerTicks)
+		ticks.store(0, std::memory_order_relaxed);
 }
 
 AudioStream * AudioSubmodule::CreateAudioStream(AudioWriter::Base * audioWriter)
 {
-	AudioStream * ret = AudioStream::Create(system, audioWriter);
+	AudioStream * ret = AudioStream::Create(audioWriter);
+	if (config.parallelStreams)
+	{
+		ret->output = AudioBuffer::Allocate(scratchFrames, outputChannels);
+		if (config.realtime.prefault)
+			AudioRealtime::Prefault(ret->output, scratchFrames * outputChannels * sizeof(float));
+	}
+	
 	pool.push_back(ret);
+	
+	// the lists are sized here so the mixer's never grow on its thread
+	StreamSet * set = new StreamSet();
+	set->streams = pool;
+	set->renderList.reserve(pool.size());
+	set->renderedList.reserve(pool.size());
+	set->rankList.reserve(pool.size());
+	set->generation = streamGeneration.load(std::memory_order_relaxed);
+	PublishStreams(set);
 	return ret;
 }
 
@@ -44,37 +58,618 @@ void AudioSubmodule::UpdateAudioStream(float dt)
 
 void AudioSubmodule::DestroyAudioStreams()
 {
+	// anything still queued or pending points into the trees about to go;
+	// the new generation tells the mixer to drop it, and once the empty
+	// set is published no block can reach the old streams
+	StreamSet * set = new StreamSet();
+	set->generation = streamGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+	PublishStreams(set);
+	
 	for(auto & audio : pool)
 		AudioStream::Destroy(audio);
 	
 	pool.clear();
 }
 
-void AudioSubmodule::Init()
+// game thread only; returns once the mixer can't be using the old set
+void AudioSubmodule::PublishStreams(StreamSet * set)
+{
+	StreamSet * old = streamSet.exchange(set, std::memory_order_seq_cst);
+	WaitForMix();
+	delete old;
+}
+
+// Mix bumps mixEpoch going into a block and again coming out, so an odd
+// value means a block is running that may have loaded whatever was
+// published before this call.  One that starts later loads the new one
+void AudioSubmodule::WaitForMix()
+{
+	const uint32_t epoch = mixEpoch.load(std::memory_order_seq_cst);
+	if ((epoch & 1) == 0)
+		return;
+	
+	while (mixEpoch.load(std::memory_order_acquire) == epoch)
+		bx::yield();
+}
+
+bool AudioSubmodule::Post(const AudioCommand & command)
+{
+	AudioCommand stamped = command;
+	stamped.generation = streamGeneration.load(std::memory_order_relaxed);
+	return commands.Push(stamped);
+}
+
+// takes up the set the game thread last published; commands left over
+// from an older generation name destroyed streams, so they go
+void AudioSubmodule::AdoptStreamSet()
+{
+	StreamSet * set = streamSet.load(std::memory_order_seq_cst);
+	if (set->generation != mixGeneration)
+	{
+		int32_t kept = 0;
+		for (int32_t c = 0; c < pendingCount; c++)
+		{
+			if (int32_t(pending[c].generation - set->generation) >= 0)
+				pending[kept++] = pending[c];
+		}
+		
+		pendingCount = kept;
+	}
+	
+	mixSet = set;
+	mixGeneration = set->generation;
+}
+
+// moves what's been posted into pending, in frame order; only Mix calls
+// it, which keeps the mixer the queue's only consumer.  When pending is
+// full the rest stay queued until a later block makes room, since
+// applying one now could land it ahead of its frame
+void AudioSubmodule::DrainCommands()
+{
+	AudioCommand command;
+	while (pendingCount < kMaxPending && commands.Pop(command))
+	{
+		if (int32_t(command.generation - mixSet->generation) < 0)
+			continue;
+		
+		// commands for the same frame keep the order they were posted in
+		int32_t slot = pendingCount;
+		while (slot > 0 && pending[slot - 1].frame > command.frame)
+		{
+			pending[slot] = pending[slot - 1];
+			slot--;
+		}
+		
+		pending[slot] = command;
+		pendingCount++;
+	}
+}
+
+void AudioSubmodule::ApplyCommand(const AudioCommand & command)
+{
+	switch (command.type)
+	{
+		case AudioCommand::kStart:
+			if (command.stream)
+				command.stream->Start();
+			break;
+			
+		case AudioCommand::kStop:
+			if (command.stream)
+				command.stream->Stop();
+			break;
+			
+		case AudioCommand::kSetVolume:
+			if (command.stream)
+				command.stream->volume = command.value;
+			break;
+			
+		case AudioCommand::kSetPan:
+			if (command.stream)
+				command.stream->pan = command.value;
+			break;
+			
+		case AudioCommand::kSetParam:
+		case AudioCommand::kRampParam:
+			if (command.writer)
+				ApplyParam(command);
+			break;
+			
+		case AudioCommand::kPlayNote:
+			if (command.instrument)
+				command.instrument->NoteOn({ 0.0f, command.value, command.gain, command.duration });
+			break;
+	}
+}
+
+void AudioSubmodule::ApplyParam(const AudioCommand & command)
+{
+	AudioWriter::Base * writer = command.writer;
+	
+	// a writer muted from here may be unmuted later, so it mustn't be
+	// retired for going quiet
+	if (command.param == AudioCommand::kGain)
+		writer->gainCommanded = true;
+	
+	// an automated writer reads its lanes, not the flat fields
+	AudioWriter::AutomationLane * lane = nullptr;
+	if (writer->automation && command.param == AudioCommand::kGain)
+		lane = &writer->automation->gain;
+	if (writer->automation && command.param == AudioCommand::kPitch)
+		lane = &writer->automation->pitch;
+	
+	if (lane)
+	{
+		if (command.type == AudioCommand::kRampParam)
+			lane->RampTo(command.value, command.rampFrames);
+		else
+			lane->Reset(command.value);
+		return;
+	}
+	
+	switch (command.param)
+	{
+		case AudioCommand::kGain: writer->gain = command.value; break;
+		case AudioCommand::kPitch: writer->pitch = command.value; break;
+		case AudioCommand::kPhase: writer->phase = command.value; break;
+	}
+}
+
+void AudioSubmodule::Mix(float * buffer, int32_t numFrames)
+{
+	// no lock: the game thread swaps sets and captures and then waits for
+	// the epoch to move, rather than ever holding up the mixer
+	mixEpoch.fetch_add(1, std::memory_order_seq_cst);
+	if (mixing.load(std::memory_order_acquire))
+		MixBlock(buffer, numFrames);
+	mixEpoch.fetch_add(1, std::memory_order_release);
+}
+
+void AudioSubmodule::MixBlock(float * buffer, int32_t numFrames)
+{
+	if (!mixThreadReady)
+	{
+		mixThreadReady = true;
+		if (const char * failed = AudioRealtime::SetupThread(config.realtime, 0))
+			threadError.store(failed, std::memory_order_relaxed);
+	}
+	
+	AdoptStreamSet();
+	
+	// the writers see this block's lod through a copy; the global context
+	// never changes after Init, since the game thread reads it too
+	blockContext = context;
+	blockContext.lod = lodGovernor.GetLod();
+	AudioWriter::ContextScope scope(blockContext);
+	
+	const int64_t mixStart = bx::getHPCounter();
+	for (auto * audio : mixSet->streams)
+		audio->renderTicks.store(0, std::memory_order_relaxed);
+	for (auto & ticks : workerTicks)
+		ticks.store(0, std::memory_order_relaxed);
+	streamsRendered.store(0, std::memory_order_relaxed);
+	
+	DrainCommands();
+	
+	const uint64_t blockFrame = mixFrame.load(std::memory_order_relaxed);
+	
+	// the backend may ask for more than the scratch holds, so walk the
+	// block in scratch sized pieces, also cut wherever a command is due;
+	// every voice sees the same piece boundaries, which keeps them sample
+	// aligned with each other
+	int32_t start = 0;
+	while (start < numFrames)
+	{
+		const uint64_t now = blockFrame + start;
+		
+		int32_t applied = 0;
+		while (applied < pendingCount && pending[applied].frame <= now)
+			ApplyCommand(pending[applied++]);
+		
+		if (applied > 0)
+		{
+			pendingCount -= applied;
+			for (int32_t c = 0; c < pendingCount; c++)
+				pending[c] = pending[c + applied];
+		}
+		
+		int32_t frames = numFrames - start;
+		if (frames > scratchFrames)
+			frames = scratchFrames;
+		if (pendingCount > 0 && pending[0].frame < now + frames)
+			frames = int32_t(pending[0].frame - now);
+		
+		RankVoices();
+		
+		// mono mixes straight into the backend's block; more channels mix
+		// into the planar bus, which is interleaved into the block in one
+		// pass
+		if (busSpace)
+		{
+			const AudioBuffer bus(busSpace, frames, outputChannels, AudioBuffer::GetPlaneStride(scratchFrames));
+			RenderStreams(bus);
+			AudioMix::Add(AudioBuffer(buffer + start * outputChannels, frames, outputChannels), bus);
+			AudioMix::Zero(bus);
+		}
+		else
+			RenderStreams(AudioBuffer(buffer + start, frames, 1));
+		
+		start += frames;
+	}
+	
+	mixFrame.store(blockFrame + numFrames, std::memory_order_release);
+	
+	int64_t renderTicks = 0;
+	for (auto * audio : mixSet->streams)
+		renderTicks += audio->renderTicks.load(std::memory_order_relaxed);
+	streamTicks.store(renderTicks, std::memory_order_relaxed);
+	const int64_t ticks = bx::getHPCounter() - mixStart;
+	mixTicks.store(ticks, std::memory_order_relaxed);
+	
+	// the block's cost against its own duration sets the next one's detail
+	const double blockTicks = double(numFrames) * double(bx::getHPFrequency()) / double(context.hertz);
+	lodGovernor.Update(float(double(ticks) / blockTicks), blockFrame);
+	
+	if (AudioCapture * capturing = capture.load(std::memory_order_acquire))
+		capturing->Push(buffer, numFrames);
+}
+
+// a real voice ranks as if this much louder, so voices near the cut
+// don't trade places, and fade, every block
+static const float kKeepReal = 1.25f;
+
+void AudioSubmodule::RankVoices()
+{
+	std::vector<AudioStream*> & rankList = mixSet->rankList;
+	rankList.clear();
+	for (auto * audio : mixSet->streams)
+	{
+		audio->virtualVoice = false;
+		if (!audio->playing.load(std::memory_order_acquire) || audio->finished.load(std::memory_order_relaxed))
+			continue;
+		
+		// a tree that hasn't rendered yet has no level to go on, and going
+		// virtual would fade its first block out and the next back in
+		AudioWriter::Base * root = audio->audioTree.root;
+		if (root && !root->inited)
+			continue;
+		
+		audio->audibility = root ? audio->volume * root->GetLevel() : 0.0f;
+		rankList.push_back(audio);
+	}
+	
+	if (config.realVoices <= 0)
+	{
+		virtualVoices.store(0, std::memory_order_relaxed);
+		return;
+	}
+	
+	// only the cut matters, not the order on either side of it
+	const size_t real = size_t(config.realVoices);
+	if (rankList.size() > real)
+	{
+		std::nth_element(rankList.begin(), rankList.begin() + real, rankList.end(), [](const AudioStream * a, const AudioStream * b)
+		{
+			return a->audibility * (a->wasVirtual ? 1.0f : kKeepReal) > b->audibility * (b->wasVirtual ? 1.0f : kKeepReal);
+		});
+	}
+	
+	int32_t skipped = 0;
+	for (size_t r = 0; r < rankList.size(); r++)
+	{
+		AudioStream * audio = rankList[r];
+		audio->virtualVoice = r >= real || audio->audibility < config.virtualLevel;
+		skipped += audio->virtualVoice ? 1 : 0;
+	}
+	
+	virtualVoices.store(skipped, std::memory_order_relaxed);
+}
+
+void AudioSubmodule::RenderStreams(const AudioBuffer & out)
 {
-	errorCode = FMOD::System_Create(&system);      // Create the main system object.
-	if (errorCode != FMOD_OK)
+	if (workerScratch)
 	{
-		PostFMODError(errorCode);
+		RenderStreamsParallel(out);
+		return;
 	}
-	else
+	
+	const int64_t begin = bx::getHPCounter();
+	
+	int32_t rendered = 0;
+	for (auto * audio : mixSet->streams)
+		rendered += audio->Render(out, AudioBuffer(scratchSpace, out.frames, context.channels)) ? 1 : 0;
+	
+	streamsRendered.fetch_add(rendered, std::memory_order_relaxed);
+	workerTicks[0].fetch_add(bx::getHPCounter() - begin, std::memory_order_relaxed);
+}
+
+void AudioSubmodule::SetupWorker(void * userData, int32_t worker)
+{
+	AudioSubmodule * self = (AudioSubmodule *) userData;
+	if (const char * failed = AudioRealtime::SetupThread(self->config.realtime, worker))
+		self->threadError.store(failed, std::memory_order_relaxed);
+}
+
+// writers' own threads, like a PipelineStage's, run behind the mixer's
+// blocks, so they get its priority, and cores of their own
+void AudioSubmodule::SetupStageThread(void * userData)
+{
+	AudioSubmodule * self = (AudioSubmodule *) userData;
+	const int32_t workers = JobPool::Instance() ? JobPool::Instance()->GetNumWorkers() : 1;
+	const int32_t index = workers + self->stageThreads.fetch_add(1, std::memory_order_relaxed);
+	if (const char * failed = AudioRealtime::SetupThread(self->config.realtime, index))
+		self->threadError.store(failed, std::memory_order_relaxed);
+}
+
+void AudioSubmodule::RenderStreamTask(void * userData, int32_t task, int32_t worker)
+{
+	AudioSubmodule * self = (AudioSubmodule *) userData;
+	AudioWriter::ContextScope scope(self->blockContext);
+	const int64_t begin = bx::getHPCounter();
+	
+	// each worker's scratch starts on its own aligned plane
+	const int32_t channels = self->context.channels;
+	const size_t scratchLen = size_t(AudioBuffer::GetPlaneStride(self->scratchFrames)) * channels;
+	const AudioBuffer scratch(self->workerScratch + size_t(worker) * scratchLen, self->renderBus.frames, channels);
+	
+	StreamSet * set = self->mixSet;
+	AudioStream * audio = set->renderList[task];
+	const AudioBuffer output = self->renderBus.SameLayout(audio->output, self->renderBus.frames, self->scratchFrames);
+	AudioMix::Zero(output);
+	set->renderedList[task] = audio->Render(output, scratch) ? 1 : 0;
+	
+	self->workerTicks[worker].fetch_add(bx::getHPCounter() - begin, std::memory_order_relaxed);
+}
+
+void AudioSubmodule::RenderStreamsParallel(const AudioBuffer & out)
+{
+	// only streams that will render are worth a task; renderList was
+	// reserved for the whole set, so this never allocates
+	std::vector<AudioStream*> & renderList = mixSet->renderList;
+	std::vector<uint8_t> & renderedList = mixSet->renderedList;
+	renderList.clear();
+	for (auto * audio : mixSet->streams)
+	{
+		if (!audio->output || !audio->playing.load(std::memory_order_acquire) || audio->finished.load(std::memory_order_relaxed))
+			continue;
+		
+		// a voice that stays virtual only skips, which isn't worth a task
+		if (audio->virtualVoice && audio->wasVirtual)
+			audio->Render(out, AudioBuffer(scratchSpace, out.frames, context.channels));
+		else
+			renderList.push_back(audio);
+	}
+	
+	renderedList.assign(renderList.size(), 0);
+	renderBus = out;
+	
+	// realtime work: the pool puts this ahead of anything queued
+	JobPool::Instance()->ParallelFor(RenderStreamTask, this, int32_t(renderList.size()));
+	
+	// summed in pool order, never completion order, so the result doesn't
+	// depend on which worker got there first
+	int32_t rendered = 0;
+	for (size_t c = 0; c < renderList.size(); c++)
 	{
-		errorCode = system->init(32, FMOD_INIT_NORMAL, 0);    // Initialize FMOD.
-		if (errorCode != FMOD_OK)
+		if (renderedList[c])
 		{
-			PostFMODError(errorCode);
+			AudioMix::Add(out, out.SameLayout(renderList[c]->output, out.frames, scratchFrames));
+			rendered++;
 		}
 	}
+	
+	streamsRendered.fetch_add(rendered, std::memory_order_relaxed);
+}
+
+AudioSubmodule::MixStats AudioSubmodule::GetMixStats() const
+{
+	const double frequency = double(bx::getHPFrequency());
+	const int64_t mix = mixTicks.load(std::memory_order_relaxed);
+	
+	MixStats stats;
+	stats.mixSeconds = float(double(mix) / frequency);
+	stats.streamSeconds = float(double(streamTicks.load(std::memory_order_relaxed)) / frequency);
+	stats.streamsRendered = streamsRendered.load(std::memory_order_relaxed);
+	stats.virtualVoices = virtualVoices.load(std::memory_order_relaxed);
+	stats.lod = lodGovernor.GetLod();
+	stats.workers = JobPool::Instance() ? JobPool::Instance()->GetNumWorkers() : 1;
+	
+	for (int32_t w = 0; w < stats.workers && mix > 0; w++)
+		stats.workerLoad[w] = float(double(workerTicks[w].load(std::memory_order_relaxed)) / double(mix));
+	
+	return stats;
+}
+
+bool AudioSubmodule::StartCapture(const char * path, AudioWav::SampleFormat format)
+{
+	StopCapture();
+	
+	AudioCapture * opened = new AudioCapture();
+	if (!opened->Open(path, context.hertz, outputChannels, format))
+	{
+		PostError(opened->GetError());
+		delete opened;
+		return false;
+	}
+	
+	capture.store(opened, std::memory_order_release);
+	return true;
+}
+
+void AudioSubmodule::StopCapture()
+{
+	AudioCapture * closing = capture.exchange(nullptr, std::memory_order_seq_cst);
+	if (!closing)
+		return;
+	
+	// a block that loaded it before the swap may still be pushing
+	WaitForMix();
+	
+	// Close waits on the writer thread and the disk, so keep it outside
+	// the lock the mixer needs
+	closing->Close();
+	if (closing->GetError())
+		PostError(closing->GetError());
+	delete closing;
+}
+
+uint64_t AudioSubmodule::GetClock() const
+{
+	return backend ? backend->GetClock() : 0;
+}
+
+float AudioSubmodule::GetOutputLatency() const
+{
+	return backend ? backend->GetOutputLatency() : 0.0f;
+}
+
+float AudioSubmodule::GetStreamLatency(const AudioStream * stream) const
+{
+	return GetOutputLatency() + (stream ? stream->GetPipelineLatency() : 0.0f);
+}
+
+void AudioSubmodule::PostError(const char * errorString)
+{
+	error = errorString;
+	if (config.onError)
+		config.onError(errorString);
+}
+
+void AudioSubmodule::Init()
+{
+	Init(Config());
+}
+
+void AudioSubmodule::Init(const Config & initConfig)
+{
+	config = initConfig;
+	mixThreadReady = false;
+	
+	// before anything is allocated, so the pools below are locked too
+	if (config.realtime.lockMemory)
+	{
+		if (const char * failed = AudioRealtime::LockMemory())
+			PostError(failed);
+	}
+	
+	// sized by frames rather than seconds, so higher rates don't starve
+	// the writers; the backend may start pulling as soon as it's up, so
+	// this has to exist first
+	scratchFrames = config.maxBlockFrames;
+	scratchSpace = AudioBuffer::Allocate(scratchFrames, context.channels);
+	if (config.realtime.prefault)
+		AudioRealtime::Prefault(scratchSpace, scratchFrames * context.channels * sizeof(float));
+	
+	commands.Init(uint32_t(config.commandCapacity));
+	pendingCount = 0;
+	mixSet = nullptr;
+	mixGeneration = streamGeneration.load(std::memory_order_relaxed);
+	streamSet.store(new StreamSet(), std::memory_order_release);
+	lodGovernor.Init(config.lod);
+	context.lod = 0;
+	mixFrame.store(0, std::memory_order_relaxed);
+	
+	if (!streamer.Init(config.streaming))
+		PostError("sample streamer couldn't start its thread");
+	
+	if (!sampleBank.Init(config.bank))
+		PostError("sample bank couldn't start its thread");
+	
+	// the pool belongs to the app, which starts it before us and stops
+	// it after; without one streams just render serially
+	JobPool * jobs = JobPool::Instance();
+	if (config.parallelStreams && jobs)
+	{
+		const size_t planeLen = size_t(AudioBuffer::GetPlaneStride(scratchFrames)) * context.channels;
+		workerScratch = AudioBuffer::Allocate(scratchFrames, jobs->GetNumWorkers() * context.channels);
+		if (config.realtime.prefault)
+			AudioRealtime::Prefault(workerScratch, jobs->GetNumWorkers() * planeLen * sizeof(float));
+	}
+	else if (config.parallelStreams)
+		PostError("no job pool to render streams on; rendering them serially");
+	
+	if (jobs)
+		jobs->SetupWorkers(SetupWorker, this);
+	
+	backend = AudioBackend::Create(config.backend);
+	if (!backend)
+	{
+		PostError("audio backend not available in this build");
+		return;
+	}
+	
+	AudioBackend::Format format;
+	format.hertz = config.hertz;
+	format.channels = config.channels < 1 ? 1 : (config.channels > AudioMix::kMaxChannels ? AudioMix::kMaxChannels : config.channels);
+	format.blockFrames = config.blockFrames;
+	
+	// on failure the backend has already posted its error; keep it
+	// around so Shutdown can release whatever it did create
+	if (backend->Init(this, format))
+		context.hertz = format.hertz;
+	
+	// the trees keep rendering in context.channels; the bus takes however
+	// many the device settled on, planar, so each voice pans onto it
+	outputChannels = format.channels;
+	if (outputChannels > 1)
+	{
+		busSpace = AudioBuffer::Allocate(scratchFrames, outputChannels);
+		if (config.realtime.prefault)
+			AudioRealtime::Prefault(busSpace, AudioBuffer::GetPlaneStride(scratchFrames) * outputChannels * sizeof(float));
+	}
+	
+	context.maxBlockFrames = scratchFrames;
+	context.subBlockFrames = config.subBlockFrames;
+	context.retireLevel = config.retireLevel;
+	context.retireFrames = int32_t(config.retireSeconds * float(context.hertz));
+	context.setupThread = SetupStageThread;
+	context.setupData = this;
+	AudioWriter::SetContext(context);
+	mixing.store(true, std::memory_order_release);
 }
 
 void AudioSubmodule::Update()
 {
-	system->update();
+	if (const char * failed = threadError.exchange(nullptr, std::memory_order_relaxed))
+		PostError(failed);
+	
+	lodGovernor.Collect();
+	
+	if (backend)
+		backend->Update();
 }
 
 void AudioSubmodule::Shutdown()
 {
+	// stop the backend first so nothing is mixing while the pool goes away
+	mixing.store(false, std::memory_order_release);
+	if (backend)
+	{
+		backend->Shutdown();
+		AudioBackend::Destroy(backend);
+	}
+	
+	// samplers release their voices and views as the trees go, so the
+	// streamer and bank have to outlive the pool
 	DestroyAudioStreams();
-	system->release();
+	
+	// the pool outlives us, so workers mustn't call back in later
+	if (JobPool::Instance())
+		JobPool::Instance()->SetupWorkers(nullptr, nullptr);
+	context.setupThread = nullptr;
+	context.setupData = nullptr;
+	AudioWriter::SetContext(context);
+	streamer.Shutdown();
+	sampleBank.Shutdown();
+	StopCapture();
+	
+	delete streamSet.exchange(nullptr, std::memory_order_relaxed);
+	mixSet = nullptr;
+	
+	AudioBuffer::Free(scratchSpace);
+	scratchSpace = nullptr;
+	AudioBuffer::Free(workerScratch);
+	workerScratch = nullptr;
+	AudioBuffer::Free(busSpace);
+	busSpace = nullptr;
 }
-
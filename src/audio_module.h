@@ -8,40 +8,238 @@
 #ifndef AudioModule_h
 #define AudioModule_h
 
-#include <fmod/fmod_errors.h>
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 
-#include "bgfx_utils.h"
+#include "audio_backend.h"
+#include "audio_bank.h"
+#include "audio_capture.h"
+#include "audio_commands.h"
+#include "audio_lod.h"
+#include "audio_queue.h"
+#include "audio_realtime.h"
+#include "audio_streamer.h"
 #include "audio_writers.h"
 #include "audio_stream.h"
-
-namespace FMOD
-{
-	class System;
-	class Sound;
-}
-
-void PostFMODError(FMOD_RESULT result);
+#include "job_pool.h"
 
 class AudioSubmodule
 {
-	FMOD::System *system = nullptr;
-	FMOD::Sound *buffer = nullptr;
-	FMOD_RESULT errorCode = FMOD_OK;
+	// owns the device and decides when Mix gets called
+	AudioBackend * backend = nullptr;
+	const char * error = nullptr;
 	
+	// every stream created, on the game thread's side
 	using AudioPool = std::vector<AudioStream*>;
 	AudioPool pool;
 	
+	// the mixer's copy of the pool.  The game thread never edits a set
+	// Mix might be reading: it builds a new one, swaps it in, and frees the
+	// old one once no block can still be using it.  Each set carries render
+	// lists sized for its streams, so the mixer never allocates
+	struct StreamSet
+	{
+		AudioPool streams;
+		std::vector<AudioStream*> renderList;
+		std::vector<uint8_t> renderedList;
+		std::vector<AudioStream*> rankList;
+		
+		// commands posted before this generation may name streams that
+		// are gone, so the mixer drops them
+		uint32_t generation = 0;
+	};
+	std::atomic<StreamSet*> streamSet { nullptr };
+	std::atomic<uint32_t> streamGeneration { 0 };
+	
+	// the set for the block being mixed, and the generation of the last
+	// one adopted, kept apart since that set may be freed by now; mixer only
+	StreamSet * mixSet = nullptr;
+	uint32_t mixGeneration = 0;
+	
+	// odd while Mix is inside a block, which is how the game thread knows
+	// when a set or capture it swapped out is no longer in use
+	std::atomic<uint32_t> mixEpoch { 0 };
+	
+	// Mix outputs silence until the backend has settled on a format and
+	// the writers' context matches it
+	std::atomic<bool> mixing { false };
+	
+	// realtime setup for the backend's thread is done on its first Mix,
+	// since that's the first time it's known; failures on audio threads
+	// wait here for Update to report them
+	bool mixThreadReady = false;
+	std::atomic<const char *> threadError { nullptr };
+	
+	// threads writers start for themselves, counted so each is pinned
+	// after the mixer and the job workers
+	std::atomic<int32_t> stageThreads { 0 };
+	
+	// render target for one voice before it is summed into the bus
+	float * scratchSpace = nullptr;
+	int32_t scratchFrames = 0;
+	
+	// the bus, planar, when there's more than one output channel; with
+	// one, voices mix straight into the backend's block
+	float * busSpace = nullptr;
+	int32_t outputChannels = 1;
+	
+	// commands posted from any thread, drained by Mix at each block
+	AudioQueue<AudioCommand> commands;
+	
+	// drained commands waiting on a later frame, soonest first; mixer only
+	static const int32_t kMaxPending = 256;
+	AudioCommand pending[kMaxPending];
+	int32_t pendingCount = 0;
+	
+	// frames mixed since Init, the clock command frames are measured on
+	std::atomic<uint64_t> mixFrame { 0 };
+	
+	// when set, every mixed block is also queued to disk; swapped out and
+	// waited on with WaitForMix before it's closed
+	std::atomic<AudioCapture*> capture { nullptr };
+	
+	// feeds Sampler voices from disk
+	SampleStreamer streamer;
+	
+	// samples decoded once and shared by every Sampler playing them
+	SampleBank sampleBank;
+	
+	// parallel stream mixing: a render target per worker, the piece being
+	// rendered, and what the last Mix cost
+	float * workerScratch = nullptr;
+	AudioBuffer renderBus;
+	
+	std::atomic<int32_t> virtualVoices { 0 };
+	
+	// picks each block's lod from what the last one cost
+	LodGovernor lodGovernor;
+	
+	// context with this block's lod, which the writers render under;
+	// context itself is left alone since the game thread reads it.  Mixer
+	// only, and its workers while it waits on them
+	AudioWriter::Context blockContext;
+	
+	std::atomic<int64_t> workerTicks[JobPool::kMaxWorkers];
+	std::atomic<int64_t> mixTicks { 0 };
+	std::atomic<int64_t> streamTicks { 0 };
+	std::atomic<int32_t> streamsRendered { 0 };
+	
 	static AudioSubmodule * sInstance;
 	
+	static void SetupWorker(void * userData, int32_t worker);
+	static void SetupStageThread(void * userData);
+	static void RenderStreamTask(void * userData, int32_t task, int32_t worker);
+	void MixBlock(float * buffer, int32_t numFrames);
+	void RankVoices();
+	void RenderStreams(const AudioBuffer & out);
+	void RenderStreamsParallel(const AudioBuffer & out);
+	
+	void DrainCommands();
+	void AdoptStreamSet();
+	void ApplyCommand(const AudioCommand & command);
+	void ApplyParam(const AudioCommand & command);
+	
+	void PublishStreams(StreamSet * set);
+	void WaitForMix();
+	
 public:
-	struct Context
+	using ErrorFn = void (*)(const char * error);
+	
+	struct Config
 	{
-		int32_t hertz = 48000;
+#if AUDIO_CONFIG_FMOD
+		AudioBackend::Type backend = AudioBackend::kFMODStream;
+#else
+		AudioBackend::Type backend = AudioBackend::kNullRealtime;
+#endif
+		
+		// output rate; 0 follows the device
+		int32_t hertz = 0;
+		
+		// output channels: 1, 2 for stereo, 4 for quad or 6 for 5.1, up to
+		// AudioMix::kMaxChannels; the device may settle on another count.
+		// Trees still render mono and streams pan onto these
+		int32_t channels = 1;
+		
+		// block size for the null backends
+		int32_t blockFrames = 512;
+		
+		// the most frames a writer renders at once; bigger device blocks
+		// are mixed in pieces of this size
+		int32_t maxBlockFrames = 4096;
+		
+		// each stream renders its piece of a block through its tree this
+		// many frames at a time, so the tree's intermediate buffers stay
+		// in L1/L2; 0 renders whole pieces.  Voice ranking, commands and
+		// parallel dispatch still happen per piece
+		int32_t subBlockFrames = 0;
+		
+		// commands that can be in flight between the game and the mixer
+		// before Post starts failing
+		int32_t commandCapacity = 1024;
+		
+		// render the streams for each block on the job pool instead of one
+		// after another; each stream renders into its own buffer and the
+		// buffers are summed in pool order, so the mix comes out the same
+		// whichever worker took which stream
+		bool parallelStreams = false;
+		
+		// streams rendered for real, the most audible first; the rest go
+		// virtual and only keep time until they rank high enough to be
+		// heard again.  0 renders every stream
+		int32_t realVoices = 64;
+		
+		// streams estimated quieter than this go virtual even inside the
+		// budget; 0.00001 is -100 dB
+		float virtualLevel = 0.00001f;
+		
+		// voices whose output stays under retireLevel for retireSeconds are
+		// retired rather than played out to their duration, once nothing
+		// more can start under them; 0.0000158 is -96 dBFS, 0 turns it off
+		float retireLevel = 0.0000158f;
+		float retireSeconds = 0.05f;
+		
+		// where engine failures get reported, on top of GetError
+		ErrorFn onError = nullptr;
+		
+		SampleStreamer::Config streaming;
+		SampleBank::Config bank;
+		
+		LodGovernor::Config lod;
+		
+		// priority, core pinning and memory locking for the mixer thread
+		// and the job workers; the workers are shared with the app, so
+		// their background jobs run at the same priority, still queued
+		// behind audio blocks
+		AudioRealtime::Config realtime;
+	};
+	
+	using Context = AudioWriter::Context;
+	
+	// what the last mixed block cost; per stream numbers are on the streams
+	struct MixStats
+	{
+		// wall time of the whole Mix call
+		float mixSeconds = 0.0f;
+		
+		// cpu time summed over every stream rendered
+		float streamSeconds = 0.0f;
+		int32_t streamsRendered = 0;
+		
+		// streams that only kept time in the last piece of the block
+		int32_t virtualVoices = 0;
+		
+		// level of detail the next block renders at
+		int32_t lod = 0;
+		
+		// busy fraction of each worker over the Mix call, caller first
+		int32_t workers = 1;
+		float workerLoad[JobPool::kMaxWorkers] = {};
 	};
 	
 	Context context;
+	Config config;
 	
 	AudioSubmodule();
 	
@@ -51,13 +249,54 @@ public:
 	void DestroyAudioStreams();
 	void UpdateAudioStream(float dt);
 	
+	// sums every playing stream into buffer; called from whatever thread
+	// the backend pulls blocks on
+	void Mix(float * buffer, int32_t numFrames);
+	
+	// queues a command for the mixer; safe from any thread and never
+	// blocks, returns false if the queue is full
+	bool Post(const AudioCommand & command);
+	
+	// the mixer's clock, for timestamping commands; frames already mixed
+	// are in the past, so schedule at least a block or two ahead
+	uint64_t GetMixFrame() const { return mixFrame.load(std::memory_order_acquire); }
+	
+	// records the bus to a wav file until StopCapture or Shutdown
+	bool StartCapture(const char * path, AudioWav::SampleFormat format = AudioWav::kFloat32);
+	void StopCapture();
+	
 	void Init();
+	void Init(const Config & config);
 	void Update();
 	void Shutdown();
 	
 	const Context & GetContext() const { return context; }
 	
-	FMOD_RESULT GetError() const { return errorCode; }
+	// channels in the blocks handed to the backend
+	int32_t GetOutputChannels() const { return outputChannels; }
+	
+	SampleBank & GetSampleBank() { return sampleBank; }
+	
+	// frames the backend has delivered since Init
+	uint64_t GetClock() const;
+	
+	// seconds between a block being rendered and it reaching the device;
+	// add AudioStream::GetTriggerLatency for the full trigger to ear time
+	float GetOutputLatency() const;
+	
+	// output latency plus whatever the stream's pipeline stages add
+	float GetStreamLatency(const AudioStream * stream) const;
+	
+	// any thread; fields may straddle two blocks
+	MixStats GetMixStats() const;
+	
+	// the level of detail the governor has the writers at, and its recent
+	// changes as of the last Update, for tuning its thresholds
+	int32_t GetLod() const { return lodGovernor.GetLod(); }
+	const std::deque<LodTransition> & GetLodHistory() const { return lodGovernor.GetHistory(); }
+	
+	void PostError(const char * error);
+	const char * GetError() const { return error; }
 };
 
 #endif /* AudioModule_h */
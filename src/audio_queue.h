@@ -0,0 +1,103 @@
+//
+//  audio_queue.h
+//  audiosample
+//
+
+#ifndef audio_queue_h
+#define audio_queue_h
+
+#include <stdint.h>
+#include <atomic>
+
+// Bounded queue for any number of producers and one consumer, with every
+// slot allocated up front.  Push and Pop never lock or allocate: each
+// slot carries a sequence number that says whose turn it is, producers
+// claim slots with a compare and swap on the write position, and a full
+// queue makes Push fail instead of wait.  Safe to pop on the audio thread.
+template <typename Ty>
+class AudioQueue
+{
+	struct Cell
+	{
+		std::atomic<uint32_t> sequence { 0 };
+		Ty value;
+	};
+
+	Cell * cells = nullptr;
+	uint32_t mask = 0;
+
+	// padded so producers and the consumer don't share a cache line
+	uint8_t padWrite[64];
+	std::atomic<uint32_t> writePosition { 0 };
+	uint8_t padRead[64];
+	uint32_t readPosition = 0;
+
+public:
+	AudioQueue() {}
+	AudioQueue(const AudioQueue &) = delete;
+	AudioQueue & operator = (const AudioQueue &) = delete;
+
+	~AudioQueue() { delete [] cells; }
+
+	// rounds up to a power of two; not thread safe, call before use
+	void Init(uint32_t minCapacity)
+	{
+		uint32_t capacity = 2;
+		while (capacity < minCapacity)
+			capacity <<= 1;
+		mask = capacity - 1;
+
+		delete [] cells;
+		cells = new Cell[capacity];
+		for (uint32_t c = 0; c < capacity; c++)
+			cells[c].sequence.store(c, std::memory_order_relaxed);
+
+		writePosition.store(0, std::memory_order_relaxed);
+		readPosition = 0;
+	}
+
+	// any thread; false if the queue is full
+	bool Push(const Ty & value)
+	{
+		Cell * cell;
+		uint32_t position = writePosition.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			cell = &cells[position & mask];
+			const uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const int32_t turn = int32_t(sequence - position);
+
+			if (turn == 0)
+			{
+				if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (turn < 0)
+				return false;
+			else
+				position = writePosition.load(std::memory_order_relaxed);
+		}
+
+		cell->value = value;
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer only; false if nothing is ready
+	bool Pop(Ty & value)
+	{
+		Cell * cell = &cells[readPosition & mask];
+		const uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+		if (int32_t(sequence - (readPosition + 1)) < 0)
+			return false;
+
+		value = cell->value;
+		cell->sequence.store(readPosition + mask + 1, std::memory_order_release);
+		readPosition++;
+		return true;
+	}
+};
+
+#endif /* audio_queue_h */
@@ -0,0 +1,198 @@
+//
+//  audio_realtime.cpp
+//  audiosample
+//
+
+#include "audio_realtime.h"
+
+#include <bx/bx.h>
+
+#if BX_PLATFORM_WINDOWS
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#	include <sched.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#	if defined(__GLIBC__)
+#		include <malloc.h>
+#	endif
+#endif
+
+namespace AudioRealtime
+{
+
+static const int32_t kPageBytes = 4096;
+
+// left untouched below the deepest page TouchStack reaches, for whatever
+// the thread calls afterwards and for guard pages; each call also costs
+// its own frame on top of the page it touches
+static const size_t kStackMargin = 32 << 10;
+static const size_t kFrameBytes = 256;
+
+// bytes between here and the end of the calling thread's stack, or 0 if
+// that can't be found out.  Matters because the mixer may be running on
+// a thread the backend made, with a stack much smaller than stackBytes
+static size_t StackRemaining()
+{
+	volatile uint8_t here = 0;
+	const uintptr_t current = uintptr_t(&here);
+	uintptr_t lowest = 0;
+
+#if BX_PLATFORM_WINDOWS
+	MEMORY_BASIC_INFORMATION info;
+	if (VirtualQuery((const void *) current, &info, sizeof(info)) == 0)
+		return 0;
+	lowest = uintptr_t(info.AllocationBase);
+#elif BX_PLATFORM_OSX || BX_PLATFORM_IOS
+	pthread_t self = pthread_self();
+	lowest = uintptr_t(pthread_get_stackaddr_np(self)) - pthread_get_stacksize_np(self);
+#elif defined(__GLIBC__) || BX_PLATFORM_ANDROID
+	pthread_attr_t attr;
+	if (pthread_getattr_np(pthread_self(), &attr) != 0)
+		return 0;
+
+	void * address = nullptr;
+	size_t size = 0;
+	const int32_t result = pthread_attr_getstack(&attr, &address, &size);
+	pthread_attr_destroy(&attr);
+	if (result != 0)
+		return 0;
+	lowest = uintptr_t(address);
+#endif
+
+	return lowest != 0 && current > lowest ? size_t(current - lowest) : 0;
+}
+
+// one page of stack per call; the read after the recursion keeps the
+// compiler from turning it into a loop that reuses one frame
+static BX_NO_INLINE int32_t TouchStack(int32_t pages)
+{
+	volatile uint8_t page[kPageBytes];
+	page[0] = 0;
+	page[kPageBytes - 1] = 0;
+
+	const int32_t below = pages > 1 ? TouchStack(pages - 1) : 0;
+	return below + page[0];
+}
+
+// the index-th set bit of cores, wrapping; -1 if there are none
+static int32_t PickCore(uint64_t cores, int32_t index)
+{
+	int32_t count = 0;
+	for (uint64_t bits = cores; bits; bits &= bits - 1)
+		count++;
+
+	if (count == 0)
+		return -1;
+
+	int32_t skip = index % count;
+	for (int32_t core = 0; core < 64; core++)
+	{
+		if ((cores >> core) & 1)
+		{
+			if (skip == 0)
+				return core;
+			skip--;
+		}
+	}
+
+	return -1;
+}
+
+static const char * SetPriority(int32_t priority)
+{
+#if BX_PLATFORM_WINDOWS
+	BX_UNUSED(priority);
+	if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+		return "couldn't raise an audio thread to time critical priority";
+	return nullptr;
+#else
+	const int32_t lowest = sched_get_priority_min(SCHED_FIFO);
+	const int32_t highest = sched_get_priority_max(SCHED_FIFO);
+
+	sched_param param = {};
+	param.sched_priority = priority < lowest ? lowest : priority > highest ? highest : priority;
+	if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+		return "couldn't give an audio thread SCHED_FIFO priority; it needs CAP_SYS_NICE or an rtprio limit";
+	return nullptr;
+#endif
+}
+
+static const char * SetCore(int32_t core)
+{
+#if BX_PLATFORM_WINDOWS
+	if (!SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core))
+		return "couldn't pin an audio thread to its core";
+	return nullptr;
+#elif BX_PLATFORM_LINUX || BX_PLATFORM_ANDROID
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+		return "couldn't pin an audio thread to its core";
+	return nullptr;
+#else
+	BX_UNUSED(core);
+	return "pinning audio threads to cores isn't supported on this platform";
+#endif
+}
+
+const char * SetupThread(const Config & config, int32_t index)
+{
+	const char * error = nullptr;
+
+	if (config.priority > 0)
+		error = SetPriority(config.priority);
+
+	const int32_t core = PickCore(config.cores, index);
+	if (core >= 0)
+	{
+		const char * coreError = SetCore(core);
+		error = error ? error : coreError;
+	}
+
+	// never deeper than the stack actually goes; when it can't be told,
+	// not at all, rather than risk running off the end
+	if (config.prefault && config.stackBytes > 0)
+	{
+		const size_t remaining = StackRemaining();
+		const size_t usable = remaining > kStackMargin ? remaining - kStackMargin : 0;
+		const int32_t fits = int32_t(usable / (kPageBytes + kFrameBytes));
+		const int32_t wanted = (config.stackBytes + kPageBytes - 1) / kPageBytes;
+		const int32_t pages = wanted < fits ? wanted : fits;
+		if (pages > 0)
+			TouchStack(pages);
+	}
+
+	return error;
+}
+
+const char * LockMemory()
+{
+#if BX_PLATFORM_WINDOWS
+	return "locking audio memory isn't supported on this platform";
+#else
+#	if defined(__GLIBC__)
+	// freed memory stays mapped, and so locked, instead of being trimmed
+	// and faulted back in on the next allocation
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+#	endif
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+		return "couldn't lock audio memory; it needs CAP_IPC_LOCK or a big enough memlock limit";
+	return nullptr;
+#endif
+}
+
+void Prefault(void * memory, size_t bytes)
+{
+	volatile uint8_t * bytePtr = (volatile uint8_t *) memory;
+	for (size_t offset = 0; offset < bytes; offset += kPageBytes)
+		bytePtr[offset] = 0;
+	if (bytes > 0)
+		bytePtr[bytes - 1] = 0;
+}
+
+}
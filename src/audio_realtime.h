@@ -0,0 +1,53 @@
+//
+//  audio_realtime.h
+//  audiosample
+//
+
+#ifndef audio_realtime_h
+#define audio_realtime_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Scheduling and memory setup for the threads that render audio, so a
+// busy renderer or game thread can't preempt a block into an underrun
+// and the mixer never stalls on a page fault.  Everything here reports
+// what failed rather than quietly running without it; realtime priority
+// and memory locking usually need privileges the process may not have.
+namespace AudioRealtime
+{
+	struct Config
+	{
+		// SCHED_FIFO at this priority on Linux and macOS, time critical
+		// on Windows; 0 leaves scheduling alone
+		int32_t priority = 0;
+
+		// cores the audio threads run on, bit n for core n.  Thread index
+		// i is pinned to the i-th set bit, wrapping, so the mixer gets the
+		// first and each job worker its own; 0 leaves affinity alone
+		uint64_t cores = 0;
+
+		// mlockall the process, current and future pages, and keep malloc
+		// from handing memory back to the system
+		bool lockMemory = false;
+
+		// touch each audio thread's stack and the mixer's buffers up front
+		// so the first blocks don't fault them in; the stack touch stops
+		// short of the thread's real stack size, which on a backend's own
+		// thread may be well under stackBytes
+		bool prefault = false;
+		int32_t stackBytes = 128 << 10;
+	};
+
+	// applies config to the calling thread; null on success, otherwise
+	// what didn't take.  The rest is still applied after a failure.
+	const char * SetupThread(const Config & config, int32_t index);
+
+	// null on success, otherwise why the process couldn't be locked
+	const char * LockMemory();
+
+	// writes a zero into every page of memory
+	void Prefault(void * memory, size_t bytes);
+}
+
+#endif /* audio_realtime_h */
@@ -0,0 +1,120 @@
+//
+//  audio_ring.h
+//  audiosample
+//
+
+#ifndef audio_ring_h
+#define audio_ring_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+// Single producer, single consumer ring of samples.  Neither side ever
+// blocks or allocates: Write refuses (and returns false) rather than wait
+// for room, so the audio thread can be either end of it.  The read and
+// write counters only ever grow; capacity is a power of two so wrapping
+// is a mask.
+class AudioRing
+{
+	float * samples = nullptr;
+	uint32_t capacity = 0;
+	uint32_t mask = 0;
+
+	std::atomic<uint64_t> writeCount { 0 };
+	std::atomic<uint64_t> readCount { 0 };
+
+public:
+	AudioRing() {}
+	AudioRing(const AudioRing &) = delete;
+	AudioRing & operator = (const AudioRing &) = delete;
+
+	~AudioRing() { free(samples); }
+
+	// rounds up to a power of two; not thread safe, call before use
+	void Init(uint32_t minCapacity)
+	{
+		capacity = 1;
+		while (capacity < minCapacity)
+			capacity <<= 1;
+		mask = capacity - 1;
+
+		free(samples);
+		samples = (float *) malloc(capacity * sizeof(float));
+		Reset();
+	}
+
+	// not thread safe, both sides must be idle
+	void Reset()
+	{
+		writeCount.store(0, std::memory_order_relaxed);
+		readCount.store(0, std::memory_order_relaxed);
+	}
+
+	uint32_t GetCapacity() const { return capacity; }
+
+	// producer side
+	uint32_t GetFree() const
+	{
+		const uint64_t read = readCount.load(std::memory_order_acquire);
+		const uint64_t write = writeCount.load(std::memory_order_relaxed);
+		return capacity - uint32_t(write - read);
+	}
+
+	// consumer side
+	uint32_t GetAvailable() const
+	{
+		const uint64_t write = writeCount.load(std::memory_order_acquire);
+		const uint64_t read = readCount.load(std::memory_order_relaxed);
+		return uint32_t(write - read);
+	}
+
+	// all or nothing; a partial write would tear a block in half
+	bool Write(const float * src, uint32_t numSamples)
+	{
+		if (numSamples > GetFree())
+			return false;
+
+		const uint64_t write = writeCount.load(std::memory_order_relaxed);
+		const uint32_t start = uint32_t(write) & mask;
+		const uint32_t first = numSamples < capacity - start ? numSamples : capacity - start;
+
+		memcpy(samples + start, src, first * sizeof(float));
+		memcpy(samples, src + first, (numSamples - first) * sizeof(float));
+
+		writeCount.store(write + numSamples, std::memory_order_release);
+		return true;
+	}
+
+	// reads up to numSamples, returns how many were read
+	uint32_t Read(float * dst, uint32_t numSamples)
+	{
+		const uint32_t available = GetAvailable();
+		if (numSamples > available)
+			numSamples = available;
+
+		const uint64_t read = readCount.load(std::memory_order_relaxed);
+		const uint32_t start = uint32_t(read) & mask;
+		const uint32_t first = numSamples < capacity - start ? numSamples : capacity - start;
+
+		memcpy(dst, samples + start, first * sizeof(float));
+		memcpy(dst + first, samples, (numSamples - first) * sizeof(float));
+
+		readCount.store(read + numSamples, std::memory_order_release);
+		return numSamples;
+	}
+
+	// drops up to numSamples without copying them out
+	uint32_t Skip(uint32_t numSamples)
+	{
+		const uint32_t available = GetAvailable();
+		if (numSamples > available)
+			numSamples = available;
+
+		readCount.fetch_add(numSamples, std::memory_order_release);
+		return numSamples;
+	}
+};
+
+#endif /* audio_ring_h */
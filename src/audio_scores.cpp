@@ -0,0 +1,632 @@
+//
+//  audio_scores.cpp
+//  audiosample
+//
+//  Created by Mike Gonzales on 8/21/20.
+//
+
+#include "audio_scores.h"
+#include "audio_bank.h"
+#include "audio_capture.h"
+#include <bx/filepath.h>
+#include <math.h>
+#include <stdio.h>
+
+const float kBeatsPerMinute = 80.0f;
+const float kBeatsPerSecond = kBeatsPerMinute / 60.0f;
+const float kBeatTime = 1.0f / kBeatsPerSecond;
+const float kAHertzValue = 440.0f;
+const int32_t kBeatsPerMeasure = 3;
+const int32_t kLeadInBeat = 0;
+
+enum NoteStep
+{
+	kNoteA1 = -12,
+	kNoteBb1 = -11,
+	kNoteC1 = -9,
+	kNoteD1 = -7,
+	kNoteE1 = -5,
+	kNoteF1 = -4,
+	kNoteG1 = -2,
+	kNoteA2 = 0,
+	kNoteBb2 = 1,
+	kNoteC2 = 3,
+	kNoteD2 = 5,
+	kNoteE2 = 7,
+	kNoteF2 = 8,
+	kNoteG2 = 10,
+	kNoteA3 = 12,
+	
+	kRest = 1024
+};
+
+struct NoteValue
+{
+	float startTime;
+	NoteStep note;
+	float duration;
+};
+
+/*
+C - .75
+C - .25
+
+D - 1     	F	(F, A, C)
+C - 1
+F - 1
+
+E - 2    	C7	(C, G, Bb)
+C - .75
+C - .25
+
+D - 1
+C - 1
+G - 1
+
+F - 2		F	(F, A, C)
+C - .75
+C - .25
+
+C^ - 1
+A - 1
+F - 1
+
+E - 1		Bb	(Bb, D, F)
+D - 1
+Bb - .75
+Bb - .25
+
+A - 1		C	(C, E, G)
+F - 1
+G - 1		C7 	(C, E, Bb)
+
+F - 2		F
+*/
+
+static NoteValue melody[] =
+{
+	{ 0.0f, kRest, 2.0f },	// Measure 0
+	{ 2.0f, kNoteC1, 0.75f },
+	{ 2.75f, kNoteC1, 0.25f },
+	
+	{ 3.0f, kNoteD1, 1.0f },	// Measure 1
+	{ 4.0f, kNoteC1, 1.0f },
+	{ 5.0f, kNoteF1, 1.0f },
+	
+	{ 6.0f, kNoteE1, 2.0f },	// Measure 2
+	{ 8.0f, kNoteC1, 0.75f },
+	{ 8.75f, kNoteC1, 0.25f },
+	
+	{ 9.0f, kNoteD1, 1.0f },	// Measure 3
+	{ 10.0f, kNoteC1, 1.0f },
+	{ 11.0f, kNoteG1, 1.0f },
+	
+	{ 12.0f, kNoteF1, 2.0f },	// Measure 4
+	{ 14.0f, kNoteC1, 0.75f },
+	{ 14.75f, kNoteC1, 0.25 },
+	
+	{ 15.0f, kNoteC2, 1.0f },	// Measure 5
+	{ 16.0f, kNoteA2, 1.0f },
+	{ 17.0f, kNoteF1, 1.0f },
+	
+	{ 18.0f, kNoteE1, 1.0f },	// Measure 6
+	{ 19.0f, kNoteD1, 1.0f },
+	{ 20.0f, kNoteBb2, 0.75f },
+	{ 20.75f, kNoteBb2, 0.25f },
+	
+	{ 21.0f, kNoteA2, 1.0f },	// Measure 7
+	{ 22.0f, kNoteF1, 1.0f },
+	{ 23.0f, kNoteG1, 1.0f },
+	
+	{ 24.0f, kNoteF1, 2.0f },	// Measure 8
+};
+
+static NoteValue harmony[] =
+{
+	{ 3.0f, kNoteA1, 2.75f },
+	{ 3.0f, kNoteC1, 2.75f },
+	{ 3.0f, kNoteF1, 2.75f },
+	
+	{ 6.0f, kNoteBb1, 2.75f },
+	{ 6.0f, kNoteC1, 2.75f },
+	{ 6.0f, kNoteG1, 2.75f },
+	
+	{ 9.0f, kNoteBb1, 2.75f },
+	{ 9.0f, kNoteC1, 2.75f },
+	{ 9.0f, kNoteG1, 2.75f },
+	
+	{ 12.0f, kNoteA1, 2.75f },
+	{ 12.0f, kNoteC1, 2.75f },
+	{ 12.0f, kNoteF1, 2.75f },
+	
+	{ 15.0f, kNoteA1, 2.75f },
+	{ 15.0f, kNoteC1, 2.75f },
+	{ 15.0f, kNoteF1, 2.75f },
+	
+	{ 18.0f, kNoteBb1, 2.75f },
+	{ 18.0f, kNoteD1, 2.75f },
+	{ 18.0f, kNoteF1, 2.75f },
+	
+	{ 21.0f, kNoteC1, 1.5f },
+	{ 21.0f, kNoteE1, 1.5f },
+	{ 21.0f, kNoteG1, 1.5f },
+	
+	{ 23.0f, kNoteC1, 1.0f },
+	{ 23.0f, kNoteE1, 1.0f },
+	{ 23.0f, kNoteBb2, 1.0f},
+	
+	{ 24.0f, kNoteF1, 2.75f },
+	{ 24.0f, kNoteA2, 2.75f },
+	{ 24.0f, kNoteC2, 2.75f },
+};
+
+
+float NoteStepToHertz(NoteStep steps)
+{
+	const float stepValue = powf(2.0f, 1.0f/12.0f);
+	const float toSteps = float(steps);
+	float hertz = kAHertzValue * powf(stepValue, toSteps);
+	return hertz;
+}
+
+AudioWriter::Base * GenerateNoteComposite(NoteValue note, AudioWriter::WaveFn wave, float baseGain)
+{
+	float basePitch = NoteStepToHertz(note.note);
+	
+	AudioWriter::Tone * fund = new AudioWriter::Tone(wave);
+	fund->gain = baseGain * 0.5f;
+	fund->pitch = basePitch;
+	fund->duration = kBeatTime * note.duration * 1.1f;
+	
+	AudioWriter::Tone * second = new AudioWriter::Tone(wave);
+	second->gain = baseGain * 0.25f;
+	second->pitch = 2.0f * basePitch;
+	second->duration = kBeatTime * note.duration * 1.1f;
+	
+	AudioWriter::Tone * tert = new AudioWriter::Tone(wave);
+	tert->gain = baseGain * 0.125f;
+	tert->pitch = 4.0f * basePitch;
+	tert->duration = kBeatTime * note.duration * 1.1f;
+	
+	AudioWriter::Tone * quart = new AudioWriter::Tone(wave);
+	quart->gain = baseGain * 0.0625f;
+	quart->pitch = 8.0f * basePitch;
+	quart->duration = kBeatTime * note.duration * 1.1f;
+	
+	// the upper harmonics go first when the mixer is short on time
+	second->cullLod = 3;
+	tert->cullLod = 2;
+	quart->cullLod = 1;
+	
+	AudioWriter::Composite * comp = new AudioWriter::Composite();
+	comp->PushChild(fund);
+	comp->PushChild(second);
+	comp->PushChild(tert);
+	comp->PushChild(quart);
+	
+	return comp;
+}
+
+AudioWriter::Base * GenerateNoteWriter(NoteValue note, AudioWriter::WaveFn wave, float baseGain, AudioWriter::EnvelopeBase * shape = nullptr)
+{
+	if (note.note == kRest)
+	{
+		delete shape;
+		return nullptr;
+	}
+	
+	auto * tone = GenerateNoteComposite(note, wave, baseGain);
+	
+	auto * env = new AudioWriter::Envelope(shape ? shape : new AudioWriter::AttackSustainDecayEnvelope);
+	env->child = tone;
+	
+	auto * param = new AudioWriter::ParamOverride();
+	param->gain = 0.701f;
+	param->pitch = NoteStepToHertz(note.note);
+	param->duration = kBeatTime * note.duration * 1.1f;
+	
+	param->child = env;
+	return param;
+}
+
+// retunes a voice from GenerateNoteWriter for another note, the way
+// GenerateNoteComposite laid its harmonics out
+static void TuneNoteVoice(AudioWriter::Base * voice, const AudioWriter::Instrument::Note & note)
+{
+	auto * param = static_cast<AudioWriter::ParamOverride *>(voice);
+	param->pitch = note.pitch;
+	param->duration = note.duration;
+	
+	auto * env = static_cast<AudioWriter::Envelope *>(param->child);
+	auto * comp = static_cast<AudioWriter::Composite *>(env->child);
+	
+	float harmonic = 1.0f;
+	float level = 0.5f;
+	for (auto * tone : comp->children)
+	{
+		tone->pitch = note.pitch * harmonic;
+		tone->gain = note.gain * level;
+		tone->duration = note.duration;
+		
+		harmonic *= 2.0f;
+		level *= 0.5f;
+	}
+}
+
+AudioWriter::Base * SimpleTest()
+{
+	auto note = GenerateNoteWriter({0.0f, kNoteA2, 2.0f}, AudioWriter::SineWave, 0.35f);
+	auto treeNote = AudioWriter::Tree(note);
+	
+	auto * sin = new AudioWriter::Tone(AudioWriter::SawWave);
+	
+	auto * env = new AudioWriter::Envelope(new AudioWriter::AttackSustainDecayEnvelope);
+	env->child = sin;
+	
+	auto * root = new AudioWriter::ParamOverride();
+	
+	root->child = env;
+	root->gain = 0.050f;
+	root->pitch = 440.0f;
+	root->delay = 0.75f;
+	root->duration = 1.0f;
+	return root;
+}
+
+AudioWriter::Base * SequenceTest()
+{
+	auto * root = new AudioWriter::Sequencer();
+	
+	auto * note0 = GenerateNoteWriter({0.25f, kNoteA2, 3.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note0, 0.0f);
+	
+	auto * note1 = GenerateNoteWriter({2.5f, kNoteBb2, 3.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note1, kBeatTime*3.5f);
+	
+	return root;
+}
+
+AudioWriter::Base * ChordTest()
+{
+	auto * root = new AudioWriter::Sequencer();
+	
+	auto * note0 = GenerateNoteWriter({0.0f, kNoteA2, 3.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note0, 0.8f);
+	
+	auto * note1 = GenerateNoteWriter({0.0f, kNoteC2, 3.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note1, 0.0f);
+	
+	auto * note2 = GenerateNoteWriter({0.0f, kNoteE2, 3.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note2, 0.0f);
+
+	return root;
+}
+
+AudioWriter::Base * ScaleTest()
+{
+	auto * root = new AudioWriter::Sequencer();
+	
+	auto * note0 = GenerateNoteWriter({0.0f, kNoteA1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note0, kBeatTime);
+	
+	auto * note1 = GenerateNoteWriter({1.0f, kNoteBb1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note1, kBeatTime);
+	
+	auto * note2 = GenerateNoteWriter({2.0f, kNoteC1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note2, kBeatTime);
+	
+	auto * note3 = GenerateNoteWriter({3.0f, kNoteD1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note3, kBeatTime);
+	
+	auto * note4 = GenerateNoteWriter({4.0f, kNoteE1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note4, kBeatTime);
+	
+	auto * note5 = GenerateNoteWriter({5.0f, kNoteF1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note5, kBeatTime);
+	
+	auto * note6 = GenerateNoteWriter({6.0f, kNoteG1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note6, kBeatTime);
+	
+	auto * note7 = GenerateNoteWriter({7.0f, kNoteA2, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note7, kBeatTime);
+	
+	auto * note8 = GenerateNoteWriter({8.0f, kNoteA1, 1.0f}, AudioWriter::SineWave, 0.35f);
+	root->PushChild(note8, kBeatTime);
+	
+	return root;
+}
+
+AudioWriter::Base * SequenceGenerator(NoteValue *notes, int32_t len, AudioWriter::WaveFn wave, float baseGain)
+{
+	auto * root = new AudioWriter::Sequencer();
+	for (int32_t ord = 0; ord < len; ord++)
+	{
+		auto & noteData = notes[ord];
+		
+		//Note this doens't handle successive rests
+		if (noteData.note == kRest)
+			continue;
+		
+		auto * noteInst = GenerateNoteWriter(noteData, wave, baseGain);
+		
+		float noteDelay = 0.0f;
+		if (ord > 0)
+			noteDelay = notes[ord].startTime - notes[ord - 1].startTime;
+		else
+			noteDelay = notes[ord].startTime;
+		
+		root->PushChild(noteInst,noteDelay);
+	}
+	
+	return root;
+}
+
+AudioWriter::Base * MelodyTest()
+{
+	return SequenceGenerator(melody, sizeof(melody) / sizeof(melody[0]), AudioWriter::SineWave, 0.35f);
+}
+
+AudioWriter::Base * HarmonyTest()
+{
+	return SequenceGenerator(harmony, sizeof(harmony)/sizeof(harmony[0]), AudioWriter::SawWave, 0.035f);
+}
+
+AudioWriter::Base * DenseTest()
+{
+	const int32_t kDenseVoices = 192;
+	const NoteStep chord[] = { kNoteF1, kNoteA2, kNoteC2, kNoteF2 };
+	const int32_t chordSize = sizeof(chord) / sizeof(chord[0]);
+	
+	auto * root = new AudioWriter::ParallelComposite();
+	for (int32_t voice = 0; voice < kDenseVoices; voice++)
+	{
+		NoteValue note = { 0.0f, chord[voice % chordSize], 6.0f };
+		root->PushChild(GenerateNoteWriter(note, AudioWriter::SineWave, 0.35f / float(kDenseVoices)));
+	}
+	
+	return root;
+}
+
+AudioWriter::Base * InstrumentTest()
+{
+	const int32_t kPolyphony = 8;
+	
+	auto * instrument = new AudioWriter::Instrument();
+	instrument->tune = TuneNoteVoice;
+	for (int32_t voice = 0; voice < kPolyphony; voice++)
+		instrument->AddVoice(GenerateNoteWriter({ 0.0f, kNoteA2, 1.0f }, AudioWriter::SineWave, 0.0f));
+	
+	// each chord of the harmony broken into sixteenths, an octave up every
+	// other pass, and every note held three beats
+	const int32_t numHarmony = sizeof(harmony) / sizeof(harmony[0]);
+	for (int32_t first = 0; first + 2 < numHarmony; first += 3)
+	{
+		const NoteValue * chord = harmony + first;
+		const int32_t steps = int32_t(chord[0].duration * 4.0f);
+		
+		for (int32_t step = 0; step < steps; step++)
+		{
+			const NoteValue & tone = chord[step % 3];
+			
+			AudioWriter::Instrument::Note note;
+			note.start = (tone.startTime + 0.25f * float(step)) * kBeatTime;
+			note.pitch = NoteStepToHertz(tone.note) * ((step / 3) % 2 ? 2.0f : 1.0f);
+			note.gain = 0.06f;
+			note.duration = kBeatTime * 3.0f;
+			instrument->PushNote(note);
+		}
+	}
+	
+	return instrument;
+}
+
+AudioWriter::Base * LeadTest()
+{
+	const int32_t kPolyphony = 4;
+	
+	// no tune, so each note's params land on the envelope and reach the
+	// tone through its rewind
+	auto * instrument = new AudioWriter::Instrument();
+	for (int32_t voice = 0; voice < kPolyphony; voice++)
+	{
+		auto * env = new AudioWriter::Envelope(new AudioWriter::AttackSustainDecayEnvelope);
+		env->child = new AudioWriter::Tone(AudioWriter::TriangleWave);
+		instrument->AddVoice(env);
+	}
+	
+	const int32_t numMelody = sizeof(melody) / sizeof(melody[0]);
+	for (int32_t ord = 0; ord < numMelody; ord++)
+	{
+		if (melody[ord].note == kRest)
+			continue;
+		
+		AudioWriter::Instrument::Note note;
+		note.start = melody[ord].startTime * kBeatTime;
+		note.pitch = NoteStepToHertz(melody[ord].note);
+		note.gain = 0.2f;
+		note.duration = melody[ord].duration * kBeatTime;
+		instrument->PushNote(note);
+	}
+	
+	return instrument;
+}
+
+AudioWriter::Base * PluckTest()
+{
+	auto * root = new AudioWriter::Sequencer();
+	
+	const int32_t numMelody = sizeof(melody) / sizeof(melody[0]);
+	float previousStart = 0.0f;
+	for (int32_t ord = 0; ord < numMelody; ord++)
+	{
+		if (melody[ord].note == kRest)
+			continue;
+		
+		// every note is given eight beats, far longer than it rings
+		NoteValue note = melody[ord];
+		note.duration = 8.0f;
+		
+		root->PushChild(GenerateNoteWriter(note, AudioWriter::TriangleWave, 0.35f, new AudioWriter::PluckEnvelope), (note.startTime - previousStart) * kBeatTime);
+		previousStart = note.startTime;
+	}
+	
+	return root;
+}
+
+AudioWriter::Base * PipelineTest()
+{
+	auto * stage = new AudioWriter::PipelineStage(HarmonyTest());
+	return new AudioWriter::Resampler(stage, AudioWriter::GetContext().hertz, AudioWriter::Resampler::kHigh);
+}
+
+// a stack of odd harmonics repeating every cycleFrames, so a loop cut on
+// a cycle boundary is seamless; decaying over decaySeconds if that's set.
+// The second channel sits a fifth up, 2:3, so a stereo file still loops
+// on every other cycle.
+static bool WriteSampleFile(const char * path, AudioWav::SampleFormat format, int32_t hertz, int32_t channels, int64_t frames, int32_t cycleFrames, float decaySeconds)
+{
+	const int32_t kBlockFrames = 1024;
+	
+	AudioCapture capture;
+	if (!capture.Open(path, hertz, channels, format, float(frames) / float(hertz) + 1.0f))
+		return false;
+	
+	float block[kBlockFrames * 2];
+	for (int64_t start = 0; start < frames; start += kBlockFrames)
+	{
+		const int32_t numFrames = frames - start < kBlockFrames ? int32_t(frames - start) : kBlockFrames;
+		for (int32_t frame = 0; frame < numFrames; frame++)
+		{
+			const int64_t at = start + frame;
+			const float level = decaySeconds > 0.0f ? expf(-float(at) / (decaySeconds * float(hertz))) : 1.0f;
+			for (int32_t c = 0; c < channels; c++)
+			{
+				const float cycle = float(at % (cycleFrames * 2)) / float(cycleFrames) * (c ? 1.5f : 1.0f);
+				float sample = 0.0f;
+				for (int32_t harmonic = 1; harmonic <= 5; harmonic += 2)
+					sample += sinf(kTau * cycle * float(harmonic)) / float(harmonic);
+				block[frame * channels + c] = 0.5f * level * sample;
+			}
+		}
+		
+		if (!capture.Push(block, numFrames))
+			return false;
+	}
+	
+	capture.Close();
+	return capture.GetError() == nullptr && capture.GetFramesDropped() == 0;
+}
+
+// generated samples go in the temp directory, named for the rate since a
+// Sampler plays its file at the file's own rate
+static void SamplePath(char (&path)[bx::kMaxFilePath], const char * name, int32_t hertz)
+{
+	bx::FilePath temp(bx::Dir::Temp);
+	snprintf(path, sizeof(path), "%s/audiosample_%s_%d.wav", temp.getCPtr(), name, hertz);
+}
+
+AudioWriter::Base * SampleTest()
+{
+	const int32_t hertz = AudioWriter::GetContext().hertz;
+	const int32_t kLoopCycle = 160;
+	const int32_t kHitCycle = 240;
+	
+	char loopPath[bx::kMaxFilePath];
+	char hitPath[bx::kMaxFilePath];
+	SamplePath(loopPath, "loop16", hertz);
+	SamplePath(hitPath, "hit24", hertz);
+	
+	// written once per rate
+	static int32_t writtenHertz = 0;
+	if (writtenHertz != hertz)
+	{
+		const int64_t loopFrames = int64_t(hertz) * 3 / 2;
+		const int64_t hitFrames = int64_t(hertz) * 4;
+		if (!WriteSampleFile(loopPath, AudioWav::kInt16, hertz, 1, loopFrames, kLoopCycle, 0.0f)
+			|| !WriteSampleFile(hitPath, AudioWav::kInt24, hertz, 2, hitFrames, kHitCycle, 0.8f))
+			return nullptr;
+		
+		writtenHertz = hertz;
+	}
+	
+	auto * mix = new AudioWriter::Composite();
+	
+	// two voices on the one file, the second starting halfway in, both
+	// looping the same stretch so they end up sharing its chunks
+	const int64_t loopStart = kLoopCycle * 20;
+	const int64_t loopEnd = kLoopCycle * (hertz / kLoopCycle);
+	const int64_t starts[] = { 0, int64_t(hertz) * 3 / 4 };
+	const float lengths[] = { 8.0f, 6.0f };
+	for (int32_t voice = 0; voice < 2; voice++)
+	{
+		auto * env = new AudioWriter::Envelope(new AudioWriter::AttackSustainDecayEnvelope);
+		env->child = new AudioWriter::Sampler(loopPath, starts[voice], loopStart, loopEnd);
+		env->gain = 0.2f;
+		env->duration = lengths[voice];
+		mix->PushChild(env);
+	}
+	
+	// and a one shot in a different encoding over the top
+	auto * hit = new AudioWriter::Sampler(hitPath);
+	hit->gain = 0.3f;
+	mix->PushChild(hit);
+	
+	return mix;
+}
+
+AudioWriter::Base * BankTest()
+{
+	const int32_t kNumHits = 4;
+	const int32_t kNumPreloaded = 2;
+	const int32_t kHitCycles[kNumHits] = { 240, 180, 160, 120 };
+	
+	SampleBank * bank = SampleBank::Instance();
+	if (!bank)
+		return nullptr;
+	
+	const int32_t hertz = AudioWriter::GetContext().hertz;
+	
+	char paths[kNumHits][bx::kMaxFilePath];
+	for (int32_t hit = 0; hit < kNumHits; hit++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "bank%d", hit);
+		SamplePath(paths[hit], name, hertz);
+	}
+	
+	static int32_t writtenHertz = 0;
+	if (writtenHertz != hertz)
+	{
+		for (int32_t hit = 0; hit < kNumHits; hit++)
+		{
+			if (!WriteSampleFile(paths[hit], hit % 2 ? AudioWav::kInt24 : AudioWav::kInt16, hertz, 1, hertz, kHitCycles[hit], 0.25f))
+				return nullptr;
+		}
+		
+		writtenHertz = hertz;
+	}
+	
+	// the first hits are only preloaded and let go, the way a level warms
+	// its bank, so they sit cold in the cache; once the hits that play have
+	// loaded on top of them they're over the budget and get evicted
+	for (int32_t hit = 0; hit < kNumPreloaded; hit++)
+		bank->Acquire(paths[hit]);
+	
+	// the rest play a beat apart, silent until their loads land
+	auto * mix = new AudioWriter::Composite();
+	for (int32_t hit = kNumPreloaded; hit < kNumHits; hit++)
+	{
+		auto * delay = new AudioWriter::ParamOverride();
+		delay->child = new AudioWriter::Sampler(bank->Acquire(paths[hit]));
+		delay->gain = 0.3f;
+		delay->delay = float(hit - kNumPreloaded) * kBeatTime;
+		mix->PushChild(delay);
+	}
+	
+	// and one that isn't there, whose load fails and which ends silent
+	char missingPath[bx::kMaxFilePath];
+	SamplePath(missingPath, "missing", hertz);
+	mix->PushChild(new AudioWriter::Sampler(bank->Acquire(missingPath)));
+	
+	return mix;
+}
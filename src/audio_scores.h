@@ -0,0 +1,53 @@
+//
+//  audio_scores.h
+//  audiosample
+//
+//  Created by Mike Gonzales on 8/21/20.
+//
+
+#ifndef audio_scores_h
+#define audio_scores_h
+
+#include "audio_writers.h"
+
+// test scores, each returns a freshly allocated writer tree that the
+// caller owns (usually by handing it to an AudioStream)
+
+AudioWriter::Base * SimpleTest();
+AudioWriter::Base * SequenceTest();
+AudioWriter::Base * ChordTest();
+AudioWriter::Base * ScaleTest();
+AudioWriter::Base * MelodyTest();
+AudioWriter::Base * HarmonyTest();
+
+// a held F major chord stacked kDenseVoices deep, mixed on the JobPool,
+// for measuring how well a dense score spreads across cores
+AudioWriter::Base * DenseTest();
+
+// the melody plucked, every note given eight beats though it's rung out
+// well before, for measuring what retiring quiet voices saves
+AudioWriter::Base * PluckTest();
+
+// the harmony arpeggiated in held sixteenths, a dozen notes deep, on an
+// Instrument with eight voices that steals the oldest
+AudioWriter::Base * InstrumentTest();
+
+// the melody on an Instrument of bare envelope and tone voices, played
+// without a tune function, so each note sets the voice's own params
+AudioWriter::Base * LeadTest();
+
+// the harmony a block ahead on a pipeline stage, feeding the expensive
+// high quality resampler on the calling thread
+AudioWriter::Base * PipelineTest();
+
+// streamed samples, written to the temp directory first: two voices
+// looping one 16 bit file, and a 24 bit stereo one shot.  Needs a
+// SampleStreamer; null if the files couldn't be written.
+AudioWriter::Base * SampleTest();
+
+// one shots resident in the SampleBank, written to the temp directory
+// first.  Two more are preloaded and dropped, so a small budget evicts
+// them, and one file is missing.  Needs a SampleBank.
+AudioWriter::Base * BankTest();
+
+#endif /* audio_scores_h */
@@ -7,155 +7,146 @@
 
 #include "audio_stream.h"
 
-#include <fmod/fmod.hpp>
+#include <bx/timer.h>
+#include "audio_mix.h"
 #include "audio_module.h"
 
+AudioStream::AudioStream(AudioWriter::Base * write) :
+	audioTree(write)
+{
+}
 
-FMOD_RESULT F_CALL PCMReadCallback_Zero(FMOD_SOUND * soundraw, void * data, unsigned int datalen)
+AudioStream::~AudioStream()
 {
-	uint8_t * buffer = (uint8_t *) data;
-	for (int c = 0; c < datalen; c++)
-		buffer[c] = 0;
-	
-	return FMOD_OK;
+	AudioBuffer::Free(output);
 }
 
-FMOD_RESULT F_CALL PCMSetPosCallback_Null(FMOD_SOUND * soundraw, int subsound, unsigned int position, FMOD_TIMEUNIT postype)
+AudioStream * AudioStream::Create(AudioWriter::Base * audioWriter)
 {
-	return FMOD_OK;
+	AudioStream * ret = new AudioStream(audioWriter);
+	return ret;
 }
 
-FMOD_RESULT F_CALL PCMReadCallback_Writer(FMOD_SOUND * soundraw,  void * data, unsigned int datalen)
+void AudioStream::Destroy(AudioStream *& data)
 {
-	int32_t numChannels = 1;
-	int32_t numBits = 32;
-	
-	FMOD_SOUND_FORMAT format;
-	FMOD_SOUND_TYPE type;
-	FMOD_Sound_GetFormat(soundraw, &type, &format, &numChannels, &numBits);
+	delete data;
+	data = nullptr;
+}
+
+bool AudioStream::Render(const AudioBuffer & buffer, const AudioBuffer & scratch)
+{
+	const int32_t numFrames = buffer.frames;
 	
-	const int32_t bufferLen = datalen / sizeof(float);
-	const int32_t numFrames = bufferLen / numChannels;
+	if (!playing.load(std::memory_order_acquire) || finished.load(std::memory_order_relaxed))
+		return false;
 	
-	float * buffer = (float *) data;
+	AudioWriter::Base * root = audioTree.root;
+	if (!root)
+	{
+		finished.store(true, std::memory_order_release);
+		return false;
+	}
 	
-	//over write with zeroes to make sure we have no garbage in
-	// in there to begin with
-	memset(buffer, 0, datalen);
+	const int64_t begin = bx::getHPCounter();
 	
-	AudioWriter::Base * writer;
-	FMOD_Sound_GetUserData(soundraw, (void**) &writer);
+	// initialization used to happen in FMOD's set position callback when
+	// the stream started; the mixer does it on the first block instead
+	if (!root->inited)
+		audioTree.Init();
 	
-	if (writer)
-		writer->Write(buffer, numFrames);
-	else
-		return FMOD_ERR_INVALID_PARAM;
-
-	return FMOD_OK;
-}
-
-FMOD_RESULT F_CALL PCMSetPosCallback_Initialize(FMOD_SOUND * soundraw, int subsound, unsigned int position, FMOD_TIMEUNIT postype)
-{
-	AudioWriter::Base * writer;
-	FMOD_Sound_GetUserData(soundraw, (void**) &writer);
-	if (writer && !writer->inited)
-		writer->Init();
-	else
-		return FMOD_ERR_INVALID_PARAM;
+	if (renderTick.load(std::memory_order_relaxed) == 0)
+		renderTick.store(bx::getHPCounter(), std::memory_order_relaxed);
 	
-	return FMOD_OK;
-}
-
-AudioStream::AudioStream(FMOD::System * system, AudioWriter::Base * write) :
-	system(system), audioTree(write)
-{
-	if (!system)
-		return;
+	const float fadeFrom = wasVirtual ? 0.0f : 1.0f;
+	const float fadeTo = virtualVoice ? 0.0f : 1.0f;
+	wasVirtual = virtualVoice;
 	
-	if (AudioSubmodule::Instance()->GetError() == FMOD_OK)
+	const bool rendering = !root->done && (fadeFrom > 0.0f || fadeTo > 0.0f);
+	if (rendering)
 	{
-		FMOD_MODE mode = FMOD_OPENUSER | FMOD_CREATESTREAM | FMOD_LOOP_NORMAL;
-
-		FMOD_CREATESOUNDEXINFO info = {0};
-		info.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
-		info.length = uint32_t(timeLength * hertz);
-		info.numchannels = channels;
-		info.defaultfrequency = hertz;
-		info.format = FMOD_SOUND_FORMAT_PCMFLOAT;
-		info.pcmreadcallback = PCMReadCallback_Writer;
-		info.pcmsetposcallback = PCMSetPosCallback_Initialize;
-		info.userdata = (void *) audioTree.root;
-
-		errorCode = system->createStream("", mode, &info, &handle);
-		if (errorCode != FMOD_OK)
+		// in sub-blocks, when the mixer asks for them, all rendered through
+		// the front of scratch so it stays in cache too
+		const int32_t subBlockFrames = AudioWriter::GetContext().subBlockFrames;
+		const int32_t step = subBlockFrames > 0 && subBlockFrames < numFrames ? subBlockFrames : numFrames;
+		const float fadeStep = (fadeTo - fadeFrom) / float(numFrames);
+		
+		// a mono tree is spread over the bus; one that already renders the
+		// bus's channels just scales into it
+		float gains[AudioMix::kMaxChannels];
+		AudioMix::PanGains(pan, buffer.channels, gains);
+		for (int32_t channel = 0; channel < buffer.channels; channel++)
+			gains[channel] *= volume;
+		
+		for (int32_t start = 0; start < numFrames && !root->done; start += step)
 		{
-			PostFMODError(errorCode);
+			const int32_t frames = numFrames - start < step ? numFrames - start : step;
+			const AudioBuffer target = scratch.Slice(0, frames);
+			audioTree.Write(target);
+			root->TrackPeak(target);
+			
+			// only what the tree wrote is mixed, and cleared for the next stream
+			const AudioWriter::FrameRange & range = root->written;
+			if (range.IsSilent())
+				continue;
+			
+			const AudioBuffer written = target.Slice(range.begin, range.GetFrames());
+			if (fadeFrom != fadeTo)
+				AudioMix::MultiplyRamp(written, fadeFrom + fadeStep * float(start + range.begin), fadeStep);
+			const AudioBuffer out = buffer.Slice(start + range.begin, written.frames);
+			if (written.channels == 1)
+				AudioMix::AddPanned(out, written, gains);
+			else
+				AudioMix::AddScaled(out, written, volume);
+			AudioMix::Zero(written);
 		}
 	}
-	else
-	{
-		//if the audio system as a whole has an error, copy it to our error to
-		// poison our playback so that this sound doesn't assume everything is
-		// all hunky-dory
-		errorCode = AudioSubmodule::Instance()->GetError();
-	}
+	else if (!root->done)
+		root->Skip(numFrames);
+	
+	if (root->done)
+		finished.store(true, std::memory_order_release);
+	
+	renderTicks.fetch_add(bx::getHPCounter() - begin, std::memory_order_relaxed);
+	return rendering;
 }
 
-AudioStream::~AudioStream()
+void AudioStream::Start()
 {
-	handle->release();
+	renderTick.store(0, std::memory_order_relaxed);
+	startTick.store(bx::getHPCounter(), std::memory_order_relaxed);
+	playing.store(true, std::memory_order_release);
 }
 
-AudioStream * AudioStream::Create(FMOD::System * system, AudioWriter::Base * audioWriter)
+void AudioStream::Stop()
 {
-	AudioStream * ret = new AudioStream(system, audioWriter);
-	return ret;
+	playing.store(false, std::memory_order_release);
 }
 
-void AudioStream::Destroy(AudioStream *& data)
+void AudioStream::Update(float dt)
 {
-	delete data;
-	data = nullptr;
+	if (finished.load(std::memory_order_acquire))
+		Stop();
 }
 
-void AudioStream::Start()
+float AudioStream::GetRenderSeconds() const
 {
-	if (errorCode == FMOD_OK)
-	{
-		//result = system->playSound(sound, null, false, out channel);
-		errorCode = system->playSound(handle, nullptr, true, &instance);
-		if (errorCode != FMOD_OK)
-		{
-			PostFMODError(errorCode);
-		}
-		else
-		{
-			errorCode = instance->setVolume(0.701f);
-			if (errorCode != FMOD_OK)
-			{
-				PostFMODError(errorCode);
-			}
-			else
-			{
-				errorCode = instance->setPaused(false);
-				if (errorCode != FMOD_OK)
-				{
-					PostFMODError(errorCode);
-				}
-			}
-		}
-	}
+	return float(double(renderTicks.load(std::memory_order_relaxed)) / double(bx::getHPFrequency()));
 }
 
-void AudioStream::Stop()
+float AudioStream::GetPipelineLatency() const
 {
-	if (errorCode == FMOD_OK)
-		instance->stop();
+	if (!audioTree.root)
+		return 0.0f;
+	
+	return float(audioTree.root->GetLatencyFrames()) / float(AudioWriter::GetContext().hertz);
 }
 
-void AudioStream::Update(float dt)
+float AudioStream::GetTriggerLatency() const
 {
-	if (audioTree.root && audioTree.root->done)
-		Stop();
+	const int64_t rendered = renderTick.load(std::memory_order_relaxed);
+	if (rendered == 0)
+		return -1.0f;
+	
+	const int64_t started = startTick.load(std::memory_order_relaxed);
+	return float(double(rendered - started) / double(bx::getHPFrequency()));
 }
-
@@ -8,50 +8,83 @@
 #ifndef audio_stream_h
 #define audio_stream_h
 
-#include <fmod/fmod_errors.h>
 #include <stdint.h>
+#include <atomic>
 #include "audio_writers.h"
 
-namespace FMOD
-{
-	class System;
-	class Sound;
-	class Channel;
-}
-
 namespace AudioWriter
 {
 	struct Base;
 }
 
+// An AudioStream is a voice handle on the AudioSubmodule's mixer bus.  It
+// owns a writer tree, but no output objects of its own; the submodule
+// renders every playing stream into a single bus for the backend.
 struct AudioStream
 {
-	const int32_t channels = 1;
-	const int32_t hertz = 48 * 1000;
-	const float timeLength = 2.0f; // in seconds
+	float volume = 0.701f;
 	
-	FMOD::Sound * handle = nullptr;
-	FMOD::Channel * instance = nullptr;
-	FMOD::System * system = nullptr;
-	FMOD_RESULT errorCode = FMOD_OK;
+	// -1 left to 1 right; the tree renders mono and is panned onto the
+	// bus's channels with AudioMix::PanGains, so a stereo or 5.1 bus
+	// costs a scaled add per channel rather than a tree per channel
+	float pan = 0.0f;
 	
-	AudioWriter::Tree audioTree = nullptr;
+	// written by the game thread, read by the mixer
+	std::atomic<bool> playing { false };
+	
+	// written by the mixer once the tree reports done
+	std::atomic<bool> finished { false };
+	
+	// hp counter ticks at Start and at the first block the mixer rendered
+	// afterwards, for comparing trigger latency between output paths
+	std::atomic<int64_t> startTick { 0 };
+	std::atomic<int64_t> renderTick { 0 };
+	
+	// hp counter ticks the last mixed block spent on this stream
+	std::atomic<int64_t> renderTicks { 0 };
 	
-	int32_t NumChannels() const { return channels; }
-	int32_t NumFrames() const { return int32_t(hertz * timeLength); }
-	int32_t NumSamples() const { return channels * NumFrames(); }
+	// where this stream renders when the submodule mixes streams in
+	// parallel; allocated by the submodule, a block long, planar over the
+	// bus's channels
+	float * output = nullptr;
 	
-	AudioStream(FMOD::System * system, AudioWriter::Base * audioWriter);
+	// mixer only.  audibility is volume times the tree's level, as of the
+	// last ranking; a virtual voice lost that ranking and its tree skips
+	// instead of rendering.  Going virtual fades out over one block and
+	// coming back fades in over one.
+	float audibility = 0.0f;
+	bool virtualVoice = false;
+	bool wasVirtual = false;
+	
+	AudioWriter::Tree audioTree = nullptr;
+	
+	AudioStream(AudioWriter::Base * audioWriter);
 	
 	~AudioStream();
 	
-	static AudioStream * Create(FMOD::System * system, AudioWriter::Base * audioWriter);
+	static AudioStream * Create(AudioWriter::Base * audioWriter);
 	
 	static void Destroy(AudioStream *& data);
 	
+	// called by the mixer, pans this voice's next buffer.frames into
+	// buffer using scratch (at least as long, in the tree's channels, and
+	// zeroed) as the render target, which it leaves zeroed; returns
+	// whether anything was added
+	bool Render(const AudioBuffer & buffer, const AudioBuffer & scratch);
+	
 	void Start();
 	void Stop();
 	void Update(float dt);
+	
+	// seconds from Start until the mixer first rendered this stream, or
+	// a negative value if it hasn't been rendered yet
+	float GetTriggerLatency() const;
+	
+	// seconds of cpu the last mixed block spent on this stream
+	float GetRenderSeconds() const;
+	
+	// seconds the tree's pipeline stages hold its output back
+	float GetPipelineLatency() const;
 };
 
 #endif /* audio_stream_h */
@@ -0,0 +1,424 @@
+//
+//  audio_streamer.cpp
+//  audiosample
+//
+
+#include "audio_streamer.h"
+
+#include <bx/os.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if BX_PLATFORM_WINDOWS
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+// how much of a voice the prefetch thread queues at a time, and how long
+// it rests between passes over the voices
+static const int32_t kFillFrames = 2048;
+static const uint32_t kPollMs = 5;
+
+SampleStreamer * SampleStreamer::sInstance;
+
+// maps the whole file read only if it's no bigger than maxBytes
+static bool MapFile(const char * path, uint64_t maxBytes, const uint8_t *& data, size_t & size, void *& mapping)
+{
+#if BX_PLATFORM_WINDOWS
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || uint64_t(fileSize.QuadPart) > maxBytes)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!map)
+		return false;
+
+	void * view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(map);
+		return false;
+	}
+
+	data = (const uint8_t *) view;
+	size = size_t(fileSize.QuadPart);
+	mapping = map;
+	return true;
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0 || uint64_t(st.st_size) > maxBytes)
+	{
+		close(fd);
+		return false;
+	}
+
+	void * view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED)
+		return false;
+
+	data = (const uint8_t *) view;
+	size = size_t(st.st_size);
+	mapping = nullptr;
+	return true;
+#endif
+}
+
+static void UnmapFile(const uint8_t * data, size_t size, void * mapping)
+{
+#if BX_PLATFORM_WINDOWS
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE) mapping);
+#else
+	BX_UNUSED(mapping);
+	munmap((void *) data, size);
+#endif
+}
+
+bool SampleFile::Open(const char * openPath, uint64_t mapLimit)
+{
+	path = openPath;
+
+	if (MapFile(openPath, mapLimit, mapped, mappedSize, mapping))
+	{
+		// only the header is read through this, so a view of the first
+		// 4GB is plenty
+		const uint32_t headerView = mappedSize > 0xffffffffu ? 0xffffffffu : uint32_t(mappedSize);
+		bx::MemoryReader memory(mapped, headerView);
+		if (!AudioWav::ReadInfo(&memory, info))
+			return false;
+
+		// a truncated file can claim more than it holds
+		const int64_t present = (int64_t(mappedSize) - info.dataOffset) / info.BlockAlign();
+		if (info.frames > present)
+			info.frames = present > 0 ? present : 0;
+
+		return true;
+	}
+
+	bx::Error err;
+	if (!reader.open(bx::FilePath(openPath), &err))
+		return false;
+
+	readerOpen = true;
+	return AudioWav::ReadInfo(&reader, info);
+}
+
+void SampleFile::Close()
+{
+	if (mapped)
+		UnmapFile(mapped, mappedSize, mapping);
+
+	if (readerOpen)
+		reader.close();
+
+	mapped = nullptr;
+	mappedSize = 0;
+	mapping = nullptr;
+	readerOpen = false;
+
+	for (auto & chunk : chunks)
+	{
+		free(chunk.samples);
+		chunk = Chunk();
+	}
+}
+
+const float * SampleFile::GetChunk(int64_t index, uint64_t useTick, std::vector<uint8_t> & rawStage)
+{
+	Chunk * victim = &chunks[0];
+	for (auto & chunk : chunks)
+	{
+		if (chunk.index == index)
+		{
+			chunk.lastUse = useTick;
+			return chunk.samples;
+		}
+
+		if (chunk.lastUse < victim->lastUse)
+			victim = &chunk;
+	}
+
+	int64_t frames = info.frames - index * kChunkFrames;
+	if (frames > kChunkFrames)
+		frames = kChunkFrames;
+	if (frames <= 0)
+		return nullptr;
+
+	if (!victim->samples)
+		victim->samples = (float *) malloc(kChunkFrames * info.channels * sizeof(float));
+	victim->index = -1;
+
+	const int64_t byteOffset = info.dataOffset + index * kChunkFrames * info.BlockAlign();
+	const int32_t numBytes = int32_t(frames) * info.BlockAlign();
+	const uint8_t * raw;
+
+	if (mapped)
+		raw = mapped + byteOffset;
+	else
+	{
+		if (rawStage.size() < size_t(numBytes))
+			rawStage.resize(numBytes);
+
+		bx::Error err;
+		reader.seek(byteOffset, bx::Whence::Begin);
+		if (reader.read(rawStage.data(), numBytes, &err) != numBytes)
+			return nullptr;
+
+		raw = rawStage.data();
+	}
+
+	AudioWav::Decode(raw, int32_t(frames) * info.channels, info.format, victim->samples);
+
+	victim->index = index;
+	victim->lastUse = useTick;
+	return victim->samples;
+}
+
+SampleStreamer::SampleStreamer()
+{
+	BX_ASSERT(sInstance == nullptr);
+	sInstance = this;
+}
+
+SampleStreamer::~SampleStreamer()
+{
+	Shutdown();
+	sInstance = nullptr;
+}
+
+int32_t SampleStreamer::ThreadFunc(bx::Thread * self, void * userData)
+{
+	((SampleStreamer *) userData)->Run();
+	return 0;
+}
+
+void SampleStreamer::Run()
+{
+	while (running.load(std::memory_order_acquire))
+	{
+		Service();
+		bx::sleep(kPollMs);
+	}
+}
+
+void SampleStreamer::Service()
+{
+	{
+		bx::MutexScope scope(lock);
+		serviceList = voices;
+	}
+
+	bool anyReleased = false;
+	for (auto * voice : serviceList)
+	{
+		if (voice->released.load(std::memory_order_acquire))
+			anyReleased = true;
+		else
+			Fill(voice);
+	}
+
+	if (!anyReleased)
+		return;
+
+	// only this thread frees voices, so nothing above can be holding one
+	bx::MutexScope scope(lock);
+	for (size_t c = 0; c < voices.size(); )
+	{
+		SampleVoice * voice = voices[c];
+		if (!voice->released.load(std::memory_order_acquire))
+		{
+			c++;
+			continue;
+		}
+
+		ReleaseFile(voice->file);
+		delete voice;
+		voices[c] = voices.back();
+		voices.pop_back();
+	}
+}
+
+void SampleStreamer::Fill(SampleVoice * voice)
+{
+	SampleFile * file = voice->file;
+	const AudioWav::Info & info = file->GetInfo();
+	const uint32_t fillSamples = uint32_t(kFillFrames * info.channels);
+
+	while (!voice->ended.load(std::memory_order_relaxed) && voice->ring.GetFree() >= fillSamples)
+	{
+		const bool looping = voice->loopEnd > voice->loopStart;
+		const int64_t end = looping ? voice->loopEnd : info.frames;
+
+		if (voice->position >= end)
+		{
+			if (looping)
+			{
+				voice->position = voice->loopStart;
+				continue;
+			}
+
+			voice->ended.store(true, std::memory_order_release);
+			break;
+		}
+
+		const int64_t index = voice->position / SampleFile::kChunkFrames;
+		const int64_t offset = voice->position - index * SampleFile::kChunkFrames;
+
+		int64_t frames = end - voice->position;
+		if (frames > kFillFrames)
+			frames = kFillFrames;
+		if (frames > SampleFile::kChunkFrames - offset)
+			frames = SampleFile::kChunkFrames - offset;
+
+		const float * chunk = file->GetChunk(index, ++useTick, rawStage);
+		if (!chunk)
+		{
+			// a failed read ends the voice rather than stalling it forever
+			voice->ended.store(true, std::memory_order_release);
+			break;
+		}
+
+		voice->ring.Write(chunk + offset * info.channels, uint32_t(frames * info.channels));
+		voice->position += frames;
+	}
+}
+
+void SampleStreamer::ReleaseFile(SampleFile * file)
+{
+	if (--file->refs > 0)
+		return;
+
+	for (size_t c = 0; c < files.size(); c++)
+	{
+		if (files[c] == file)
+		{
+			files[c] = files.back();
+			files.pop_back();
+			break;
+		}
+	}
+
+	delete file;
+}
+
+bool SampleStreamer::Init()
+{
+	return Init(Config());
+}
+
+bool SampleStreamer::Init(const Config & initConfig)
+{
+	config = initConfig;
+	if (!config.prefetchThread)
+		return true;
+
+	running.store(true, std::memory_order_release);
+	if (!thread.init(ThreadFunc, this, 0, "audio prefetch"))
+	{
+		running.store(false, std::memory_order_release);
+		return false;
+	}
+
+	return true;
+}
+
+void SampleStreamer::Pump()
+{
+	// racing the prefetch thread would fill a ring from two threads
+	BX_ASSERT(!running.load(std::memory_order_acquire));
+	Service();
+}
+
+void SampleStreamer::Shutdown()
+{
+	if (running.exchange(false))
+		thread.shutdown();
+
+	bx::MutexScope scope(lock);
+
+	for (auto * voice : voices)
+		delete voice;
+	voices.clear();
+
+	for (auto * file : files)
+		delete file;
+	files.clear();
+}
+
+SampleVoice * SampleStreamer::CreateVoice(const char * path, int64_t startFrame, int64_t loopStart, int64_t loopEnd)
+{
+	SampleFile * file = nullptr;
+	{
+		bx::MutexScope scope(lock);
+		for (auto * open : files)
+		{
+			if (open->path == path)
+			{
+				file = open;
+				file->refs++;
+				break;
+			}
+		}
+	}
+
+	// parse the header outside the lock so the prefetch thread keeps
+	// feeding the voices that are already playing
+	if (!file)
+	{
+		file = new SampleFile();
+		if (!file->Open(path, config.mapLimit) || file->info.frames <= 0)
+		{
+			delete file;
+			return nullptr;
+		}
+
+		file->refs = 1;
+		bx::MutexScope scope(lock);
+		files.push_back(file);
+	}
+
+	const AudioWav::Info & info = file->GetInfo();
+
+	SampleVoice * voice = new SampleVoice();
+	voice->file = file;
+	voice->position = startFrame > 0 && startFrame < info.frames ? startFrame : 0;
+
+	// loop points outside the file, or backwards, just mean no loop
+	if (loopStart >= 0 && loopEnd > loopStart && loopEnd <= info.frames)
+	{
+		voice->loopStart = loopStart;
+		voice->loopEnd = loopEnd;
+	}
+
+	uint32_t ringFrames = uint32_t(config.voiceSeconds * info.hertz);
+	if (ringFrames < 2 * kFillFrames)
+		ringFrames = 2 * kFillFrames;
+	voice->ring.Init(ringFrames * info.channels);
+
+	bx::MutexScope scope(lock);
+	voices.push_back(voice);
+	return voice;
+}
+
+void SampleStreamer::ReleaseVoice(SampleVoice * voice)
+{
+	if (voice)
+		voice->released.store(true, std::memory_order_release);
+}
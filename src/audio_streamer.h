@@ -0,0 +1,154 @@
+//
+//  audio_streamer.h
+//  audiosample
+//
+
+#ifndef audio_streamer_h
+#define audio_streamer_h
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <bx/file.h>
+#include <bx/mutex.h>
+#include <bx/thread.h>
+
+#include "audio_ring.h"
+#include "audio_wav.h"
+
+// One wav file on disk, opened once and shared by every voice playing it.
+// Small files are memory mapped; bigger ones are read through a file
+// reader.  Either way the pcm is decoded a chunk at a time into a small
+// cache, so voices playing the same stretch of a file share one read.
+class SampleFile
+{
+	friend class SampleStreamer;
+
+	struct Chunk
+	{
+		int64_t index = -1;
+		uint64_t lastUse = 0;
+		float * samples = nullptr;
+	};
+
+	static const int32_t kCachedChunks = 4;
+
+	std::string path;
+	AudioWav::Info info;
+
+	bx::FileReader reader;
+	bool readerOpen = false;
+
+	// set when the whole file is mapped
+	const uint8_t * mapped = nullptr;
+	size_t mappedSize = 0;
+	void * mapping = nullptr;
+
+	Chunk chunks[kCachedChunks];
+
+	// touched only under the streamer's lock
+	int32_t refs = 0;
+
+	bool Open(const char * path, uint64_t mapLimit);
+	void Close();
+
+	// prefetch thread only; decoded frames for one chunk, or null if the
+	// read failed
+	const float * GetChunk(int64_t index, uint64_t useTick, std::vector<uint8_t> & rawStage);
+
+public:
+	static const int32_t kChunkFrames = 16384;
+
+	const AudioWav::Info & GetInfo() const { return info; }
+	const char * GetPath() const { return path.c_str(); }
+	bool IsMapped() const { return mapped != nullptr; }
+
+	~SampleFile() { Close(); }
+};
+
+// What the prefetch thread and one Sampler share.  The prefetch thread
+// owns position and fills the ring; the audio thread only drains it.
+struct SampleVoice
+{
+	SampleFile * file = nullptr;
+	AudioRing ring;
+
+	// in file frames; looping when loopEnd > loopStart
+	int64_t position = 0;
+	int64_t loopStart = 0;
+	int64_t loopEnd = 0;
+
+	// prefetch thread has queued the last frame
+	std::atomic<bool> ended { false };
+
+	// the Sampler is gone, the prefetch thread may free this
+	std::atomic<bool> released { false };
+};
+
+// Runs the prefetch thread that keeps every streaming voice's ring topped
+// up from disk, so the audio thread never waits on a read.
+class SampleStreamer
+{
+public:
+	struct Config
+	{
+		// files at most this big are mapped instead of read
+		uint64_t mapLimit = 64ull << 20;
+
+		// how much each voice buffers ahead of the audio thread
+		float voiceSeconds = 0.5f;
+
+		// off for offline renders, which run faster than any thread could
+		// keep up with and call Pump before each block instead
+		bool prefetchThread = true;
+	};
+
+private:
+	bx::Thread thread;
+	std::atomic<bool> running { false };
+
+	// guards files and voices between the game thread and the prefetch
+	// thread; the audio thread never takes it
+	bx::Mutex lock;
+	std::vector<SampleFile *> files;
+	std::vector<SampleVoice *> voices;
+
+	// prefetch thread only
+	std::vector<SampleVoice *> serviceList;
+	std::vector<uint8_t> rawStage;
+	uint64_t useTick = 0;
+
+	Config config;
+
+	static SampleStreamer * sInstance;
+
+	static int32_t ThreadFunc(bx::Thread * self, void * userData);
+	void Run();
+	void Service();
+	void Fill(SampleVoice * voice);
+	void ReleaseFile(SampleFile * file);
+
+public:
+	SampleStreamer();
+	~SampleStreamer();
+
+	static SampleStreamer * Instance() { return sInstance; }
+
+	bool Init();
+	bool Init(const Config & config);
+	void Shutdown();
+
+	// game thread; opens or shares the file and starts prefetching from
+	// startFrame; null if the file can't be streamed
+	SampleVoice * CreateVoice(const char * path, int64_t startFrame, int64_t loopStart, int64_t loopEnd);
+
+	// any thread; the voice is freed by the prefetch thread later
+	void ReleaseVoice(SampleVoice * voice);
+
+	// one prefetch pass on the calling thread, for a streamer without its
+	// own; fills every voice's ring and frees the released ones
+	void Pump();
+};
+
+#endif /* audio_streamer_h */
@@ -0,0 +1,338 @@
+//
+//  audio_wav.cpp
+//  audiosample
+//
+
+#include "audio_wav.h"
+
+#include <bx/simd_t.h>
+#include <string.h>
+
+static const int32_t kWavHeaderSize = 44;
+static const uint16_t kWavFormatFloat = 3;
+
+static void Put16(uint8_t * out, uint16_t value)
+{
+	out[0] = uint8_t(value);
+	out[1] = uint8_t(value >> 8);
+}
+
+static void Put32(uint8_t * out, uint32_t value)
+{
+	out[0] = uint8_t(value);
+	out[1] = uint8_t(value >> 8);
+	out[2] = uint8_t(value >> 16);
+	out[3] = uint8_t(value >> 24);
+}
+
+// canonical 44 byte header: RIFF, fmt, then the data chunk header
+static void FillHeader(uint8_t * header, int32_t hertz, int32_t channels, uint32_t dataBytes)
+{
+	const uint16_t bytesPerSample = sizeof(float);
+	const uint16_t blockAlign = uint16_t(channels * bytesPerSample);
+	
+	memcpy(header + 0, "RIFF", 4);
+	Put32(header + 4, kWavHeaderSize - 8 + dataBytes);
+	memcpy(header + 8, "WAVE", 4);
+	
+	memcpy(header + 12, "fmt ", 4);
+	Put32(header + 16, 16);
+	Put16(header + 20, kWavFormatFloat);
+	Put16(header + 22, uint16_t(channels));
+	Put32(header + 24, uint32_t(hertz));
+	Put32(header + 28, uint32_t(hertz) * blockAlign);
+	Put16(header + 32, blockAlign);
+	Put16(header + 34, bytesPerSample * 8);
+	
+	memcpy(header + 36, "data", 4);
+	Put32(header + 40, dataBytes);
+}
+
+namespace AudioWav
+{
+
+static const int32_t kSimdWidth = 4;
+
+int32_t BytesPerSample(SampleFormat format)
+{
+	switch (format)
+	{
+		case kInt24: return 3;
+		case kInt16: return 2;
+		default: return sizeof(float);
+	}
+}
+
+uint16_t FormatTag(SampleFormat format)
+{
+	return format == kFloat32 ? kWavFormatFloat : 1;
+}
+
+static inline int32_t Quantize(float sample, float scale)
+{
+	sample = sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+	const float scaled = sample * scale;
+	return int32_t(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+// clamp, scale and round four samples at a time, then narrow to the
+// output width one sample at a time since that part has no simd form
+// that's portable across bx's backends.  Rounding is half away from zero
+// in both paths, so a sample encodes the same wherever it falls
+template <int32_t kBytes>
+static void EncodeInt(const float * src, int32_t numSamples, float scale, uint8_t * out)
+{
+	int32_t c = 0;
+	
+	if ((uintptr_t(src) & 15) == 0)
+	{
+		const bx::simd128_t lo = bx::simd_splat(-1.0f);
+		const bx::simd128_t hi = bx::simd_splat(1.0f);
+		const bx::simd128_t s = bx::simd_splat(scale);
+		const bx::simd128_t half = bx::simd_splat(0.5f);
+		const bx::simd128_t sign = bx::simd_isplat(0x80000000);
+		BX_ALIGN_DECL_16(int32_t quantized[kSimdWidth]);
+		
+		for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		{
+			const bx::simd128_t in = bx::simd_clamp(bx::simd_ld(src + c), lo, hi);
+			const bx::simd128_t scaled = bx::simd_mul(in, s);
+			
+			// ftoi rounds to even on sse and truncates elsewhere, so it only
+			// ever gets whole numbers: the magnitude plus a half, floored,
+			// with the sign put back
+			const bx::simd128_t magnitude = bx::simd_floor(bx::simd_add(bx::simd_abs(scaled), half));
+			bx::simd_st(quantized, bx::simd_ftoi(bx::simd_or(magnitude, bx::simd_and(scaled, sign))));
+			
+			for (int32_t l = 0; l < kSimdWidth; l++)
+			{
+				const int32_t value = quantized[l];
+				for (int32_t b = 0; b < kBytes; b++)
+					*out++ = uint8_t(value >> (8 * b));
+			}
+		}
+	}
+	
+	for ( ; c < numSamples; c++)
+	{
+		const int32_t value = Quantize(src[c], scale);
+		for (int32_t b = 0; b < kBytes; b++)
+			*out++ = uint8_t(value >> (8 * b));
+	}
+}
+
+// widen to 32 bits one sample at a time, then convert and scale four
+// at a time
+template <int32_t kBytes>
+static void DecodeInt(const uint8_t * src, int32_t numSamples, float scale, float * out)
+{
+	const int32_t shift = 32 - 8 * kBytes;
+	int32_t c = 0;
+	
+	if ((uintptr_t(out) & 15) == 0)
+	{
+		const bx::simd128_t s = bx::simd_splat(scale);
+		BX_ALIGN_DECL_16(int32_t widened[kSimdWidth]);
+		
+		for ( ; c + kSimdWidth <= numSamples; c += kSimdWidth)
+		{
+			for (int32_t l = 0; l < kSimdWidth; l++)
+			{
+				uint32_t value = 0;
+				for (int32_t b = 0; b < kBytes; b++)
+					value |= uint32_t(*src++) << (8 * b + shift);
+				widened[l] = int32_t(value) >> shift;
+			}
+			
+			bx::simd_st(out + c, bx::simd_mul(bx::simd_itof(bx::simd_ld(widened)), s));
+		}
+	}
+	
+	for ( ; c < numSamples; c++)
+	{
+		uint32_t value = 0;
+		for (int32_t b = 0; b < kBytes; b++)
+			value |= uint32_t(*src++) << (8 * b + shift);
+		out[c] = float(int32_t(value) >> shift) * scale;
+	}
+}
+
+void Decode(const uint8_t * src, int32_t numSamples, SampleFormat format, float * out)
+{
+	switch (format)
+	{
+		case kInt24:
+			DecodeInt<3>(src, numSamples, 1.0f / 8388608.0f, out);
+			break;
+		case kInt16:
+			DecodeInt<2>(src, numSamples, 1.0f / 32768.0f, out);
+			break;
+		default:
+			memcpy(out, src, numSamples * sizeof(float));
+			break;
+	}
+}
+
+static uint16_t Get16(const uint8_t * in)
+{
+	return uint16_t(in[0] | (in[1] << 8));
+}
+
+static uint32_t Get32(const uint8_t * in)
+{
+	return uint32_t(in[0]) | (uint32_t(in[1]) << 8) | (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+}
+
+static uint64_t Get64(const uint8_t * in)
+{
+	return uint64_t(Get32(in)) | (uint64_t(Get32(in + 4)) << 32);
+}
+
+bool ReadInfo(bx::ReaderSeekerI * reader, Info & info)
+{
+	static const uint16_t kFormatPcm = 1;
+	static const uint16_t kFormatExtensible = 0xfffe;
+	
+	bx::Error err;
+	uint8_t riff[12];
+	bx::seek(reader, 0, bx::Whence::Begin);
+	if (bx::read(reader, riff, sizeof(riff), &err) != sizeof(riff))
+		return false;
+	
+	const bool rf64 = 0 == memcmp(riff, "RF64", 4);
+	if ((!rf64 && 0 != memcmp(riff, "RIFF", 4)) || 0 != memcmp(riff + 8, "WAVE", 4))
+		return false;
+	
+	bool haveFormat = false;
+	uint64_t dataSize64 = 0;
+	int64_t offset = sizeof(riff);
+	
+	for (;;)
+	{
+		uint8_t chunk[8];
+		bx::seek(reader, offset, bx::Whence::Begin);
+		if (bx::read(reader, chunk, sizeof(chunk), &err) != sizeof(chunk))
+			return false;
+		
+		const uint32_t chunkSize = Get32(chunk + 4);
+		
+		if (0 == memcmp(chunk, "ds64", 4))
+		{
+			uint8_t ds64[16];
+			if (bx::read(reader, ds64, sizeof(ds64), &err) != sizeof(ds64))
+				return false;
+			dataSize64 = Get64(ds64 + 8);
+		}
+		else if (0 == memcmp(chunk, "fmt ", 4))
+		{
+			uint8_t fmt[40] = {0};
+			const int32_t fmtSize = chunkSize < sizeof(fmt) ? int32_t(chunkSize) : int32_t(sizeof(fmt));
+			if (fmtSize < 16 || bx::read(reader, fmt, fmtSize, &err) != fmtSize)
+				return false;
+			
+			// extensible keeps the real tag at the front of its sub format guid
+			uint16_t tag = Get16(fmt);
+			if (tag == kFormatExtensible && fmtSize >= 26)
+				tag = Get16(fmt + 24);
+			
+			const uint16_t bits = Get16(fmt + 14);
+			if (tag == kWavFormatFloat && bits == 32)
+				info.format = kFloat32;
+			else if (tag == kFormatPcm && bits == 24)
+				info.format = kInt24;
+			else if (tag == kFormatPcm && bits == 16)
+				info.format = kInt16;
+			else
+				return false;
+			
+			info.channels = Get16(fmt + 2);
+			info.hertz = int32_t(Get32(fmt + 4));
+			haveFormat = info.channels > 0 && info.hertz > 0;
+		}
+		else if (0 == memcmp(chunk, "data", 4))
+		{
+			if (!haveFormat)
+				return false;
+			
+			// RF64 parks the real size in ds64 and leaves 0xffffffff here
+			const uint64_t dataSize = rf64 && chunkSize == 0xffffffffu ? dataSize64 : chunkSize;
+			info.dataOffset = offset + sizeof(chunk);
+			info.frames = int64_t(dataSize / info.BlockAlign());
+			return true;
+		}
+		
+		// chunks are word aligned
+		offset += sizeof(chunk) + chunkSize + (chunkSize & 1);
+	}
+}
+
+void Encode(const float * src, int32_t numSamples, SampleFormat format, uint8_t * out)
+{
+	switch (format)
+	{
+		case kInt24:
+			EncodeInt<3>(src, numSamples, 8388607.0f, out);
+			break;
+		case kInt16:
+			EncodeInt<2>(src, numSamples, 32767.0f, out);
+			break;
+		default:
+			memcpy(out, src, numSamples * sizeof(float));
+			break;
+	}
+}
+
+}
+
+bool WavWriter::Open(const char * path, int32_t openHertz, int32_t openChannels)
+{
+	Close();
+	
+	bx::Error err;
+	if (!file.open(bx::FilePath(path), false, &err))
+		return false;
+	
+	hertz = openHertz;
+	channels = openChannels;
+	frames = 0;
+	isOpen = true;
+	
+	uint8_t header[kWavHeaderSize];
+	FillHeader(header, hertz, channels, 0);
+	file.write(header, kWavHeaderSize, &err);
+	
+	return err.isOk();
+}
+
+bool WavWriter::Write(const float * buffer, int32_t numFrames)
+{
+	if (!isOpen)
+		return false;
+	
+	bx::Error err;
+	file.write(buffer, numFrames * channels * int32_t(sizeof(float)), &err);
+	frames += numFrames;
+	
+	return err.isOk();
+}
+
+void WavWriter::Close()
+{
+	if (!isOpen)
+		return;
+	
+	// plain RIFF tops out at 4GB; past that the sizes are clamped and
+	// readers have to trust the file length
+	const uint64_t dataBytes = frames * channels * sizeof(float);
+	const uint32_t clampedBytes = dataBytes > 0xffffffffull - kWavHeaderSize ? 0xffffffffu - kWavHeaderSize : uint32_t(dataBytes);
+	
+	uint8_t header[kWavHeaderSize];
+	FillHeader(header, hertz, channels, clampedBytes);
+	
+	bx::Error err;
+	file.seek(0, bx::Whence::Begin);
+	file.write(header, kWavHeaderSize, &err);
+	file.close();
+	
+	isOpen = false;
+}
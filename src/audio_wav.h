@@ -0,0 +1,78 @@
+//
+//  audio_wav.h
+//  audiosample
+//
+
+#ifndef audio_wav_h
+#define audio_wav_h
+
+#include <stdint.h>
+#include <bx/file.h>
+
+// Sample encodings shared by the wav writers
+namespace AudioWav
+{
+
+enum SampleFormat
+{
+	kFloat32,
+	kInt24,
+	kInt16,
+};
+
+int32_t BytesPerSample(SampleFormat format);
+
+// the RIFF fmt tag, 3 for float and 1 for integer pcm
+uint16_t FormatTag(SampleFormat format);
+
+// converts numSamples floats into little endian samples of the given
+// format at out; integer formats are clamped to [-1, 1] and rounded
+void Encode(const float * src, int32_t numSamples, SampleFormat format, uint8_t * out);
+
+// the inverse, scaling integer samples back into [-1, 1)
+void Decode(const uint8_t * src, int32_t numSamples, SampleFormat format, float * out);
+
+// where the pcm lives in a file and how to read it
+struct Info
+{
+	int32_t hertz = 0;
+	int32_t channels = 0;
+	SampleFormat format = kFloat32;
+	int64_t dataOffset = 0;
+	int64_t frames = 0;
+	
+	int32_t BlockAlign() const { return channels * BytesPerSample(format); }
+};
+
+// walks the RIFF or RF64 chunk list for fmt and data; fails on anything
+// that isn't 16/24 bit integer or 32 bit float pcm
+bool ReadInfo(bx::ReaderSeekerI * reader, Info & info);
+
+}
+
+// Small blocking RIFF/WAVE writer for 32 bit float pcm.  The header goes
+// out with zero sizes on Open and gets patched on Close, so a file that
+// was never closed is still recognizable, just truncated.
+class WavWriter
+{
+	bx::FileWriter file;
+	
+	int32_t hertz = 0;
+	int32_t channels = 0;
+	uint64_t frames = 0;
+	bool isOpen = false;
+	
+public:
+	bool Open(const char * path, int32_t hertz, int32_t channels);
+	
+	// buffer is interleaved, numFrames * channels samples long
+	bool Write(const float * buffer, int32_t numFrames);
+	
+	void Close();
+	
+	uint64_t GetFrames() const { return frames; }
+	
+	~WavWriter() { Close(); }
+};
+
+#endif /* audio_wav_h */
@@ -8,15 +8,248 @@
 #ifndef audio_writers_h
 #define audio_writers_h
 
+#include <stddef.h>
 #include <stdint.h>
 #include <vector>
-#include <deque>
+
+#include "audio_bank.h"
+#include "audio_buffer.h"
+#include "audio_ring.h"
 
 const float kTau = 6.28318530718f;
 
+struct SampleVoice;
+
 namespace AudioWriter
 {
 
+// the coarsest level of detail; see Context::lod
+const int32_t kMaxLod = 3;
+
+// format the writers render at; owned by whoever drives the trees (the
+// AudioSubmodule, or an offline renderer) and set before rendering
+struct Context
+{
+	int32_t hertz = 48000;
+	int32_t channels = 1;
+	
+	// the most frames a single Write will be asked for; writers size
+	// their scratch from this
+	int32_t maxBlockFrames = 4096;
+	
+	// whoever drives a tree renders a block through it this many frames
+	// at a time, so the buffers each writer hands the next stay in cache
+	// instead of a whole block streaming through memory per writer; 0
+	// renders the whole block at once
+	int32_t subBlockFrames = 0;
+	
+	// level of detail, 0 for full quality up to kMaxLod.  The mixer raises
+	// it when blocks run close to their deadline, and writers give up
+	// quality for cpu as it goes: culled layers, cheaper filters, coarser
+	// control rates
+	int32_t lod = 0;
+	
+	// a writer whose output stays under retireLevel for retireFrames in a
+	// row is retired as if done, once CanRetire says nothing more will
+	// start under it; 0 for either plays every writer to its duration
+	float retireLevel = 0.0f;
+	int32_t retireFrames = 0;
+	
+	// run first thing on any thread a writer starts for itself, such as
+	// PipelineStage's, so it gets the same priority and core pinning as
+	// the mixer it feeds; null leaves those threads alone
+	void (*setupThread)(void * userData) = nullptr;
+	void * setupData = nullptr;
+};
+
+const Context & GetContext();
+void SetContext(const Context & context);
+
+// overrides the context on this thread until it goes out of scope, for
+// rendering a subtree at a different rate than the rest of the tree
+struct ContextScope
+{
+	ContextScope(const Context & context);
+	~ContextScope();
+	
+private:
+	Context context;
+	const Context * previous;
+};
+
+// A curve one writer parameter follows a frame at a time, so changes ramp
+// inside a block instead of stepping at its edge.  Points are authored
+// before the tree plays, in frames from the writer's start, and each one
+// is reached in a straight line from the last; RampTo starts a ramp from
+// wherever the lane is now, and is what the mixer's ramp commands call.
+// After a RampTo finishes the lane picks up the authored points again.
+struct AutomationLane
+{
+	struct Point
+	{
+		int64_t frame;
+		float value;
+	};
+	
+	// jumps to value, dropping any ramp in progress
+	void Reset(float value);
+	
+	// game thread, before the tree plays
+	void AddPoint(int64_t frame, float value);
+	
+	void RampTo(float target, int32_t frames);
+	
+	// back to frame 0 of the authored points, starting from value
+	void Rewind(float value);
+	
+	// no ramp in progress and no authored points ahead, so the value
+	// holds from here on
+	bool IsSettled() const { return segmentPosition >= segmentFrames && nextPoint >= points.size(); }
+	
+	// one value per frame for the next numFrames, advancing the lane
+	void Render(float * out, int32_t numFrames);
+	
+	float GetValue() const { return value; }
+	
+private:
+	void NextSegment();
+	
+	std::vector<Point> points;
+	size_t nextPoint = 0;
+	int64_t frame = 0;
+	
+	float value = 1.0f;
+	float start = 1.0f;
+	float target = 1.0f;
+	int32_t segmentFrames = 0;
+	int32_t segmentPosition = 0;
+};
+
+// Something that moves a parameter over time, an lfo or an envelope;
+// evaluated once per control period rather than per frame.
+struct ModSource
+{
+	virtual float Evaluate(double time) = 0;
+	virtual ~ModSource() {}
+};
+
+// Routes sources onto a writer's gain and pitch at control rate.  Every
+// controlFrames the routed sources are evaluated and summed per
+// destination, and the curves are multiplied by a straight line between
+// the last two results, so the cost goes with the number of control
+// periods and not with the frames in them.  A gain route scales by
+// 1 + depth * source; a pitch route shifts by depth * source semitones.
+// Built on the game thread before the tree plays; owns its sources.
+struct Modulation
+{
+	enum Destination
+	{
+		kGain,
+		kPitch,
+	};
+	
+	struct Route
+	{
+		int32_t source;
+		Destination destination;
+		float depth;
+	};
+	
+	std::vector<ModSource*> sources;
+	std::vector<Route> routes;
+	
+	// 16 to 64 is plenty for vibrato and tremolo
+	int32_t controlFrames = 32;
+	
+	// returns the source's index, for routing
+	int32_t AddSource(ModSource * source);
+	void AddRoute(int32_t source, Destination destination, float depth);
+	
+	void Apply(float * gainCurve, float * pitchCurve, int32_t numFrames);
+	
+	// sources are evaluated from time zero again
+	void Rewind();
+	
+	~Modulation();
+	
+private:
+	void Advance();
+	void Evaluate(float & gain, float & pitch) const;
+	
+	double time = 0.0;
+	bool primed = false;
+	int32_t controlPosition = 0;
+	float gainPrevious = 1.0f;
+	float gainNext = 1.0f;
+	float pitchPrevious = 1.0f;
+	float pitchNext = 1.0f;
+};
+
+// Gain and pitch lanes for one writer, and the per frame curves they
+// render into, with any modulation applied on top.  Tone, Sampler and
+// Resampler use the curves in place of their flat gain and pitch when a
+// writer has one, and Envelope scales its output by the gain curve.
+struct Automation
+{
+	AutomationLane gain;
+	AutomationLane pitch;
+	Modulation modulation;
+	
+	float * gainCurve = nullptr;
+	float * pitchCurve = nullptr;
+	
+	// the most frames one Render covers, from the context's maxBlockFrames
+	// when the automation was created
+	int32_t capacity = 0;
+	
+	Automation(float gain, float pitch);
+	~Automation();
+	
+	void Render(int32_t numFrames);
+	
+	// advances the lanes and modulation numFrames, in capacity sized
+	// pieces, leaving the curves holding the last one
+	void Skip(int32_t numFrames);
+	
+	// the lanes start over from the gain and pitch it was created with
+	void Rewind();
+	
+private:
+	float initialGain = 1.0f;
+	float initialPitch = 1.0f;
+};
+
+// The frames [begin, end) of a block that a Write actually wrote to; an
+// empty range is a silent block.
+struct FrameRange
+{
+	int32_t begin = 0;
+	int32_t end = 0;
+	
+	FrameRange() {}
+	FrameRange(int32_t first, int32_t last) : begin(first), end(last) {}
+	
+	bool IsSilent() const { return end <= begin; }
+	int32_t GetFrames() const { return IsSilent() ? 0 : end - begin; }
+	
+	// grows to cover range moved offset frames later
+	void Include(const FrameRange & range, int32_t offset = 0)
+	{
+		if (range.IsSilent())
+			return;
+		
+		if (IsSilent())
+		{
+			begin = range.begin + offset;
+			end = range.end + offset;
+			return;
+		}
+		
+		begin = range.begin + offset < begin ? range.begin + offset : begin;
+		end = range.end + offset > end ? range.end + offset : end;
+	}
+};
+
 struct Base
 {
 	float pitch = 1.0f;
@@ -28,14 +261,93 @@ struct Base
 	bool  done = false;
 	bool  inited = false;
 	
+	// parents skip this writer rather than render it once the context's
+	// lod reaches cullLod, for layers the sound holds up without, like
+	// upper harmonics; 0 never culls
+	int32_t cullLod = 0;
+	
+	bool IsCulled() const { return cullLod > 0 && GetContext().lod >= cullLod; }
+	
+	// asked by the parent before each Write of frames: true to Skip this
+	// writer instead.  Crossing cullLod doesn't cut a layer mid-note; it
+	// keeps rendering while it fades out, or back in, over maxBlockFrames,
+	// the way the mixer fades a voice going virtual.  FadeCull applies
+	// this call's share of the fade to what Write wrote offset frames in
+	bool SkipCulled(int32_t frames);
+	void FadeCull(const AudioBuffer & output, int32_t offset) const;
+	
+	// the cull fade's gain at the start of the last SkipCulled, where it
+	// was heading, and where it got to; set on the first call after Rewind
+	float cullFrom = 1.0f;
+	float cullTo = 1.0f;
+	float cullGain = 1.0f;
+	bool cullKnown = false;
+	
+	// loudest sample of the last block a parent mixed in, and frames in a
+	// row the output has stayed under the context's retireLevel; kept by
+	// TrackPeak while retiring is on
+	float peak = 0.0f;
+	int32_t quietFrames = 0;
+	
+	// set once the mixer's commands have taken over gain; a writer muted
+	// that way can be turned back up, so its silence is never final
+	bool gainCommanded = false;
+	
+	// called by whoever mixes this writer in, on the block it just wrote
+	// to output; once it's been quiet for the context's retireFrames and
+	// CanRetire agrees, the writer is done early.  Returns done.
+	bool TrackPeak(const AudioBuffer & output);
+	
+	// null until Automate; create it before the stream starts, since the
+	// mixer reads it without a lock
+	Automation * automation = nullptr;
+	
+	Automation & Automate();
+	
 	// does initialization, returns whether to abort
 	virtual bool Init () = 0;
 	
-	// writes to a number of frames to a buffer, returns whether to be done
-	// Buffer is assumed to be zero filled or otherwise initialized before
-	// it arrives to this write.
-	virtual bool Write (float * buffer, int32_t numFrames) = 0;
-	virtual ~Base() {}
+	// writes buffer's frames, in its channels and layout, returns whether
+	// to be done.  Buffer is assumed to be zero filled or otherwise
+	// initialized before it arrives to this write.  Every Write sets
+	// written to the frames it touched, and leaves the rest of the buffer
+	// as it found it.
+	virtual bool Write (const AudioBuffer & buffer) = 0;
+	
+	// what the last Write wrote, so parents only mix and clear that much,
+	// and skip a silent child outright
+	FrameRange written;
+	
+	// seeks numFrames forward as if they had been written, without
+	// rendering them, for voices the mixer has virtualized; clocks,
+	// sequencing and sample positions move exactly as Write would move
+	// them, so the writer picks up where it should be when it's heard
+	// again.  Returns whether to be done.
+	virtual bool Skip (int32_t numFrames) = 0;
+	
+	// back to the start, as Init left it, keeping whatever Init allocated,
+	// so a finished voice can play again without rebuilding its tree;
+	// params aren't touched, so set them after.  Returns whether it
+	// could, a streamed Sampler can't.  Mixer thread, between blocks.
+	virtual bool Rewind ();
+	
+	// roughly how loud this writer is about to be, 1 being full scale,
+	// worked out from its params and clocks rather than its output so it
+	// costs the same whether the writer is rendering or skipping
+	virtual float GetLevel() const { return gain; }
+	
+	// whether silence from here on is silence for good, so a quiet writer
+	// can be retired before its duration is up; false while something
+	// under it has yet to start, like a Sequencer's next child, while an
+	// automated gain still has somewhere to go, or once a command has set
+	// the gain
+	virtual bool CanRetire() const;
+	
+	// frames this writer's output runs behind its input, from pipeline
+	// stages anywhere below it
+	virtual int32_t GetLatencyFrames() const { return 0; }
+	
+	virtual ~Base() { delete automation; }
 };
 
 //Tree is meant to be used by value to hold on to a dynamically
@@ -55,10 +367,10 @@ struct Tree
 		return true;
 	}
 	
-	bool Write(float * buffer, int32_t numFrames)
+	bool Write(const AudioBuffer & buffer)
 	{
 		if (root)
-			return root->Write(buffer, numFrames);
+			return root->Write(buffer);
 		return true;
 	}
 	
@@ -68,6 +380,10 @@ struct Tree
 	}
 };
 
+// Pushes its own params down onto child every block.  Once the tree is
+// playing, change them with AudioCommand::SetParam through the
+// AudioSubmodule rather than writing the fields from the game thread,
+// so the mixer never copies a half updated set.
 struct ParamOverride : Base
 {
 	Base * child = nullptr;
@@ -76,7 +392,14 @@ struct ParamOverride : Base
 	void CopyParams();
 	
 	bool Init() override;
-	bool Write(float * buffer, int32_t numFrames) override;
+	bool Write(const AudioBuffer & buffer) override;
+	bool Skip(int32_t numFrames) override;
+	bool Rewind() override;
+	float GetLevel() const override { return child ? child->GetLevel() : 0.0f; }
+	int32_t GetLatencyFrames() const override { return child ? child->GetLatencyFrames() : 0; }
+	
+	// not while still waiting out the delay
+	bool CanRetire() const override { return Base::CanRetire() && time >= delay && (!child || child->CanRetire()); }
 	
 	~ParamOverride() { delete child; }
 };
@@ -93,18 +416,31 @@ struct Sequencer : Base
 private:
 	//scratch variables, calculated upon play
 	float * scratchSpace = nullptr;
-	size_t scratchLen = 0;
+	int32_t scratchFrames = 0;
 	
 	std::vector<float> timeline;
 	int32_t timelineIndex = 0;
 	
+	// children start in timeline order and are dropped once done from the
+	// front, so the ones playing are [queueIndex, timelineIndex)
 	int32_t queueIndex = 0;
-	std::deque<Base*> playQueue;
-	std::deque<float> timeQueue;
+	
+	void QueueDue(float endTime);
+	void PopDone();
 
 public:
 	bool Init() override;
-	bool Write(float *buffer, int32_t numFrames) override;
+	bool Write(const AudioBuffer & buffer) override;
+	bool Skip(int32_t numFrames) override;
+	bool Rewind() override;
+	
+	// the children playing, plus the next one if it starts within a block
+	float GetLevel() const override;
+	
+	// once every child has started, and the ones playing can
+	bool CanRetire() const override;
+	
+	int32_t GetLatencyFrames() const override;
 	
 	void CalcTotalTime();
 	void PushChild(Base * child, float cumulDelay);
@@ -119,11 +455,20 @@ struct Composite : Base
 private:
 	//scratch variables, calculated upon play
 	float * scratchSpace = nullptr;
-	size_t scratchLen = 0;
+	int32_t scratchFrames = 0;
 
 public:
 	bool Init() override;
-	bool Write(float *buffer, int32_t numFrames) override;
+	bool Write(const AudioBuffer & buffer) override;
+	bool Skip(int32_t numFrames) override;
+	bool Rewind() override;
+	
+	// the sum of the children still playing
+	float GetLevel() const override;
+	
+	bool CanRetire() const override;
+	
+	int32_t GetLatencyFrames() const override;
 	
 	void PushChild(AudioWriter::Base * child);
 	bool DetermineDone();
@@ -131,6 +476,143 @@ public:
 	~Composite() override;
 };
 
+// A Composite that renders its children on the JobPool.  Each worker sums
+// the children it takes into its own buffer, and the buffers are added
+// into the output at the end.  Blocks with less work than
+// parallelThreshold, counted in child frames, or no pool to run on, go
+// through the serial Composite instead.
+struct ParallelComposite : Composite
+{
+	int32_t parallelThreshold = 8 * 256;
+	
+	bool Init() override;
+	bool Write(const AudioBuffer & buffer) override;
+	
+	~ParallelComposite() override;
+	
+private:
+	static void RenderChild(void * userData, int32_t task, int32_t worker);
+	AudioBuffer GetWorkerBuffer(int32_t worker, int32_t index) const;
+	
+	// per worker: a sum and a child render target, workerFrames each,
+	// both kept zeroed outside of a block, and what the sum covers
+	float * workerSpace = nullptr;
+	int32_t workerFrames = 0;
+	int32_t workers = 0;
+	std::vector<FrameRange> workerWritten;
+	
+	// the block being dispatched, which the workers' sums take the layout
+	// of; workers render it under the caller's context, since context
+	// overrides are per thread
+	Context blockContext;
+	AudioBuffer block;
+};
+
+// Plays notes on a fixed set of voices, built up front and recycled, so a
+// dense passage costs at most as many voices as were added and allocates
+// nothing once it's playing.  A note that finds every voice busy steals
+// one, the oldest or the quietest, which fades out over stealFrames
+// before the note starts on it.  A voice whose note finishes goes back on
+// the free list, and is rewound rather than rebuilt for its next note, so
+// every voice has to be able to Rewind.
+//
+// Notes come from the score, pushed before the tree plays, or live from
+// AudioCommand::PlayNote.  With a score and no duration, the instrument is
+// done once its last note has; without a score it plays until stopped.
+struct Instrument : Base
+{
+	enum Steal
+	{
+		kStealOldest,
+		kStealQuietest,
+	};
+	
+	// start is in seconds from the instrument's start; live notes ignore it
+	struct Note
+	{
+		float start;
+		float pitch;
+		float gain;
+		float duration;
+	};
+	
+	// sets a rewound voice up for a note; without one the voice's own
+	// pitch, gain and duration are set
+	using TuneFn = void (*)(Base * voice, const Note & note);
+	
+	Steal steal = kStealOldest;
+	int32_t stealFrames = 64;
+	TuneFn tune = nullptr;
+	
+	// notes that stole a voice, and notes lost because every voice was
+	// already being stolen for a newer one; mixer written, for tuning
+	int32_t stolenNotes = 0;
+	int32_t droppedNotes = 0;
+	
+	// game thread, before the tree plays; the instrument owns the voice
+	void AddVoice(Base * voice);
+	void PushNote(const Note & note);
+	
+	// mixer thread, between blocks; starts the note on the next frame, or
+	// on the first one if the instrument hasn't rendered yet
+	void NoteOn(const Note & note);
+	
+	int32_t GetActiveVoices() const { return int32_t(active.size()); }
+	
+	bool Init() override;
+	bool Write(const AudioBuffer & buffer) override;
+	bool Skip(int32_t numFrames) override;
+	bool Rewind() override;
+	
+	// the voices playing, plus the next note if it starts within a block
+	float GetLevel() const override;
+	
+	// once the score is through; a live instrument never can.  Its voices
+	// are retired one by one as they go quiet
+	bool CanRetire() const override;
+	
+	int32_t GetLatencyFrames() const override;
+	
+	~Instrument() override;
+	
+private:
+	struct Voice
+	{
+		Base * root = nullptr;
+		int64_t startFrame = 0;
+		
+		// stolen: fading out over the frames left, then playing pending
+		bool stealing = false;
+		int32_t fadeFrames = 0;
+		Note pending = {};
+	};
+	
+	FrameRange Process(const AudioBuffer * buffer, int32_t numFrames);
+	FrameRange RenderVoices(const AudioBuffer * buffer, int32_t numFrames, int64_t endFrame);
+	void StartNote(const Note & note, int64_t startFrame);
+	void Begin(int32_t index, const Note & note, int64_t startFrame);
+	int32_t PickVictim() const;
+	int64_t NoteFrame(const Note & note) const;
+	
+	std::vector<Voice> voices;
+	std::vector<int32_t> freeVoices;
+	std::vector<int32_t> active;
+	
+	// the score, in start order
+	std::vector<Note> notes;
+	size_t nextNote = 0;
+	
+	// live notes that came in before Init, started on its first frame;
+	// reserved a voice's worth each by AddVoice
+	std::vector<Note> heldNotes;
+	
+	int64_t frame = 0;
+	int32_t hertz = 48000;
+	
+	float * scratchSpace = nullptr;
+	int32_t scratchFrames = 0;
+};
+
 struct EnvelopeBase
 {
 	virtual float operator () (float t) = 0;
@@ -145,20 +627,220 @@ struct Envelope : Base
 	Envelope(EnvelopeBase * envFn) : envelope(envFn) {}
 
 	bool Init() override;
-	bool Write(float *buffer, int32_t numFrames) override;
+	bool Write(const AudioBuffer & buffer) override;
+	bool Skip(int32_t numFrames) override;
+	bool Rewind() override;
+	
+	// the child's level under the louder end of the curve over the next
+	// block, so a voice still in its attack isn't taken for silent
+	float GetLevel() const override;
+	
+	bool CanRetire() const override { return Base::CanRetire() && (!child || child->CanRetire()); }
+	int32_t GetLatencyFrames() const override { return child ? child->GetLatencyFrames() : 0; }
 	
 	~Envelope() override;
 };
 
+// Plays a wav file, either streamed from disk by the SampleStreamer or
+// resident in the SampleBank.  A streamed voice is opened on construction,
+// so prefetching starts right away and the first block is ready by the
+// time the tree plays; that also keeps file opens off the audio thread,
+// which is where Init runs.  A bank sample plays silence until its load
+// finishes, then starts from startFrame.
+//
+// startFrame, loopStart and loopEnd are in the file's frames, and looping
+// is on when loopEnd > loopStart.  A loop plays until its duration runs
+// out, or for good if it has none.  The file plays at its own rate.
+struct Sampler : Base
+{
+	Sampler(const char * path, int64_t startFrame = 0, int64_t loopStart = 0, int64_t loopEnd = 0);
+	Sampler(const SampleView & sample, int64_t startFrame = 0, int64_t loopStart = 0, int64_t loopEnd = 0);
+	
+	bool Init() override;
+	bool Write(const AudioBuffer & buffer) override;
+	
+	// a resident sample just moves its position; a streamed one drains
+	// its ring as if playing, since the prefetch thread owns the file
+	// position, so only the mixing is saved
+	bool Skip(int32_t numFrames) override;
+	
+	// a resident sample goes back to its startFrame; a streamed one can't,
+	// its prefetch has already moved on
+	bool Rewind() override;
+	
+	// a file can go quiet and come back, and reading ahead to find out
+	// would cost what retiring saves, so samplers play to their end
+	bool CanRetire() const override { return false; }
+	
+	// blocks where the prefetch thread fell behind and silence went out
+	int32_t underruns = 0;
+	
+	~Sampler() override;
+	
+private:
+	// both fill buffer from its start, and say how many frames they filled
+	bool WriteStreamed(const AudioBuffer & buffer, const float * gains, int32_t gainStride, int32_t & filled);
+	bool WriteResident(const AudioBuffer & buffer, const float * gains, int32_t gainStride, int32_t & filled);
+	
+	SampleVoice * voice = nullptr;
+	float * scratchSpace = nullptr;
+	
+	SampleView sample;
+	int64_t startPosition = 0;
+	int64_t position = 0;
+	int64_t loopStart = 0;
+	int64_t loopEnd = 0;
+	bool looping = false;
+};
+
+// Renders its child at childHertz and converts it to the context's rate
+// with a windowed sinc polyphase filter.  That covers both playing a
+// sample at an arbitrary rate (set rate, 2 is an octave up) and running
+// a whole subtree at a lower internal rate to save cpu.  The filter is
+// designed at Init for the rate in effect then, so it stays anti-aliased
+// for any rate up to that one.  An automated pitch lane scales rate
+// frame by frame, for glides without zipper steps.
+struct Resampler : Base
+{
+	enum Quality
+	{
+		kLow,		// 8 taps, nearest of 64 phases
+		kMedium,	// 16 taps, nearest of 128 phases
+		kHigh,		// 32 taps, interpolated between 256 phases
+	};
+	
+	Base * child = nullptr;
+	int32_t childHertz = 48000;
+	float rate = 1.0f;
+	Quality quality = kMedium;
+	
+	Resampler(Base * child, int32_t childHertz, Quality quality = kMedium);
+	
+	bool Init() override;
+	bool Write(const AudioBuffer & buffer) override;
+	
+	// moves the read position as Write would and skips the input it
+	// passes over in the child; the window only looks ahead of the read
+	// position, so the filter picks up exactly where Write would be
+	bool Skip(int32_t numFrames) override;
+	bool Rewind() override;
+	
+	float GetLevel() const override { return child ? child->GetLevel() * gain : 0.0f; }
+	int32_t GetLatencyFrames() const override;
+	
+	// once the child can, or is done and only the filter's tail is left
+	bool CanRetire() const override { return Base::CanRetire() && (!child || childDone || child->CanRetire()); }
+	
+	~Resampler() override;
+	
+private:
+	bool Process(const AudioBuffer & buffer, const float * gains, const float * rates, int32_t curveStride);
+	void Fill(int32_t neededFrames);
+	
+	int32_t taps = 0;
+	int32_t phases = 0;
+	int32_t channels = 0;
+	
+	// phases x 4 alignments x (taps + 4), so every dot product can start
+	// on an aligned input frame
+	float * kernel = nullptr;
+	int32_t kernelStride = 0;
+	
+	// child output, one aligned plane per channel
+	float * history = nullptr;
+	int32_t historyCapacity = 0;
+	int32_t historyFrames = 0;
+	
+	// input frames still owed after the child finished, to flush the filter
+	int32_t tailFrames = 0;
+	bool childDone = false;
+	double readPosition = 0.0;
+};
+
+// Cuts a serial chain into two stages on two cores.  The child renders on
+// the stage's own thread one block ahead of whatever sits above it, so
+// while the parent processes block N the child is already on block N+1.
+// The price is latencyFrames of delay, declared through GetLatencyFrames;
+// it defaults to the context's maxBlockFrames, and should be at least the
+// block the parent asks for, or the difference renders on the caller.
+// The stage thread starts on construction, so build these on the game
+// thread like the rest of the tree.
+struct PipelineStage : Base
+{
+	Base * child = nullptr;
+	
+	PipelineStage(Base * child, int32_t latencyFrames = 0);
+	
+	bool Init() override;
+	bool Write(const AudioBuffer & buffer) override;
+	
+	// drops what the stage rendered ahead and skips the child; the ring
+	// is topped up with silence rather than rendered
+	bool Skip(int32_t numFrames) override;
+	
+	// waits out the stage thread, then refills the ring with silence
+	bool Rewind() override;
+	
+	// the child's, taken while the stage thread was idle
+	float GetLevel() const override { return childLevel; }
+	int32_t GetLatencyFrames() const override;
+	
+	// once the child is done, which the stage retires it to on its own
+	// thread; what the ring holds after that is quiet by then
+	bool CanRetire() const override { return Base::CanRetire() && childRetires; }
+	
+	~PipelineStage() override;
+	
+private:
+	static int32_t ThreadFunc(bx::Thread * self, void * userData);
+	void Run();
+	void Render(int32_t numFrames);
+	
+	void WaitForStage();
+	
+	bx::Thread thread;
+	bx::Semaphore wake;
+	std::atomic<bool> running { false };
+	
+	// frames asked of the stage thread; it posts rendered once they're in
+	// the ring, and rendering says whether that post is still to come
+	std::atomic<int32_t> requested { 0 };
+	bx::Semaphore rendered;
+	bool rendering = false;
+	
+	// the context's setupThread, taken before the thread starts
+	void (*setupThread)(void * userData) = nullptr;
+	void * setupData = nullptr;
+	
+	// rendered ahead, always latencyFrames deep between blocks
+	AudioRing ring;
+	float * stageSpace = nullptr;
+	float * readSpace = nullptr;
+	
+	int32_t latencyFrames = 0;
+	int32_t channels = 1;
+	Context stageContext;
+	float childLevel = 0.0f;
+	bool childRetires = false;
+};
+
 using WaveFn = float (*) (float time, float pitch, float phase);
 	
 struct Tone: Base
 {
 	Tone(WaveFn wv) : wave(wv) {}
 	bool Init() override;
-	bool Write (float * buffer, int32_t numFrames) override;
+	bool Write (const AudioBuffer & buffer) override;
+	bool Skip (int32_t numFrames) override;
+	bool Rewind () override;
 	
 	WaveFn wave = nullptr;
+	
+private:
+	void WriteAutomated(const AudioBuffer & buffer);
+	
+	// position in the wave's cycle, when pitch is automated
+	double cycles = 0.0;
 };
 
 // for Wave Generators
@@ -194,6 +876,38 @@ struct AttackSustainDecayEnvelope : EnvelopeBase
 {
 	float operator () (float t) override;
 };
+
+// a struck or plucked decay, rung out well before the end
+struct PluckEnvelope : EnvelopeBase
+{
+	float operator () (float t) override;
+};
+
+// modulation sources
+
+// wave is one of the wave generators, running at rate hertz; depth is
+// set on the route
+struct Lfo : ModSource
+{
+	WaveFn wave;
+	float rate;
+	float phase = 0.0f;
+	
+	Lfo(WaveFn wv, float hertz) : wave(wv), rate(hertz) {}
+	float Evaluate(double time) override;
+};
+
+// an envelope stretched over duration seconds, then held at its end
+struct ModEnvelope : ModSource
+{
+	EnvelopeBase * envelope;
+	float duration;
+	
+	ModEnvelope(EnvelopeBase * envFn, float seconds) : envelope(envFn), duration(seconds) {}
+	float Evaluate(double time) override;
+	
+	~ModEnvelope() override { delete envelope; }
+};
 }
 
 #endif /* audio_writers_h */
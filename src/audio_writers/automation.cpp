@@ -0,0 +1,148 @@
+//
+//  automation.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_mix.h"
+#include <limits.h>
+
+namespace AudioWriter
+{
+
+void AutomationLane::Reset(float resetValue)
+{
+	value = resetValue;
+	segmentFrames = 0;
+	segmentPosition = 0;
+}
+
+void AutomationLane::AddPoint(int64_t pointFrame, float pointValue)
+{
+	// kept in frame order; a point at the same frame as another lands
+	// after it
+	auto it = points.end();
+	while (it != points.begin() && (it - 1)->frame > pointFrame)
+		--it;
+
+	points.insert(it, Point { pointFrame, pointValue });
+}
+
+void AutomationLane::RampTo(float rampTarget, int32_t frames)
+{
+	if (frames <= 0)
+	{
+		Reset(rampTarget);
+		return;
+	}
+
+	start = value;
+	target = rampTarget;
+	segmentFrames = frames;
+	segmentPosition = 0;
+}
+
+void AutomationLane::Rewind(float rewindValue)
+{
+	Reset(rewindValue);
+	nextPoint = 0;
+	frame = 0;
+}
+
+void AutomationLane::NextSegment()
+{
+	// points already behind us just set the value
+	while (nextPoint < points.size() && points[nextPoint].frame <= frame)
+		value = points[nextPoint++].value;
+
+	segmentFrames = 0;
+	segmentPosition = 0;
+
+	if (nextPoint < points.size())
+	{
+		const Point & point = points[nextPoint++];
+		const int64_t frames = point.frame - frame;
+
+		start = value;
+		target = point.value;
+		segmentFrames = frames > INT_MAX ? INT_MAX : int32_t(frames);
+	}
+}
+
+void AutomationLane::Render(float * out, int32_t numFrames)
+{
+	int32_t cursor = 0;
+	while (cursor < numFrames)
+	{
+		if (segmentPosition >= segmentFrames)
+			NextSegment();
+
+		int32_t frames = numFrames - cursor;
+
+		if (segmentPosition < segmentFrames)
+		{
+			if (frames > segmentFrames - segmentPosition)
+				frames = segmentFrames - segmentPosition;
+
+			const float step = (target - start) / float(segmentFrames);
+			AudioMix::Ramp(out + cursor, start + step * float(segmentPosition), step, frames);
+
+			segmentPosition += frames;
+			value = segmentPosition == segmentFrames ? target : start + step * float(segmentPosition);
+		}
+		else
+		{
+			AudioMix::Ramp(out + cursor, value, 0.0f, frames);
+		}
+
+		cursor += frames;
+		frame += frames;
+	}
+}
+
+Automation::Automation(float startGain, float startPitch) :
+	initialGain(startGain),
+	initialPitch(startPitch)
+{
+	gain.Reset(initialGain);
+	pitch.Reset(initialPitch);
+
+	capacity = GetContext().maxBlockFrames;
+	gainCurve = AudioBuffer::Allocate(capacity, 1);
+	pitchCurve = AudioBuffer::Allocate(capacity, 1);
+}
+
+Automation::~Automation()
+{
+	AudioBuffer::Free(gainCurve);
+	AudioBuffer::Free(pitchCurve);
+}
+
+void Automation::Render(int32_t numFrames)
+{
+	gain.Render(gainCurve, numFrames);
+	pitch.Render(pitchCurve, numFrames);
+	modulation.Apply(gainCurve, pitchCurve, numFrames);
+}
+
+void Automation::Skip(int32_t numFrames)
+{
+	for (int32_t start = 0; start < numFrames; start += capacity)
+		Render(numFrames - start < capacity ? numFrames - start : capacity);
+}
+
+void Automation::Rewind()
+{
+	gain.Rewind(initialGain);
+	pitch.Rewind(initialPitch);
+	modulation.Rewind();
+}
+
+Automation & Base::Automate()
+{
+	if (!automation)
+		automation = new Automation(gain, pitch);
+	return *automation;
+}
+
+}
@@ -0,0 +1,93 @@
+//
+//  base.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_mix.h"
+
+namespace AudioWriter
+{
+
+bool Base::Rewind()
+{
+	time = 0.0f;
+	done = false;
+	peak = 0.0f;
+	quietFrames = 0;
+	cullKnown = false;
+	if (automation)
+		automation->Rewind();
+	return true;
+}
+
+bool Base::CanRetire() const
+{
+	return !gainCommanded && (!automation || automation->gain.IsSettled());
+}
+
+bool Base::SkipCulled(int32_t frames)
+{
+	const float target = IsCulled() ? 0.0f : 1.0f;
+
+	// a writer starting out culled, or not, just is; only a change fades
+	if (!cullKnown)
+	{
+		cullKnown = true;
+		cullGain = target;
+	}
+
+	cullFrom = cullGain;
+	cullTo = target;
+
+	const float moved = float(frames) / float(GetContext().maxBlockFrames);
+	if (target > cullGain)
+		cullGain = cullGain + moved < target ? cullGain + moved : target;
+	else
+		cullGain = cullGain - moved > target ? cullGain - moved : target;
+
+	return cullFrom == 0.0f && cullTo == 0.0f;
+}
+
+void Base::FadeCull(const AudioBuffer & output, int32_t offset) const
+{
+	if (cullFrom == cullTo)
+		return;
+
+	// ramps until the fade lands, then holds there: silent once faded out,
+	// untouched once faded back in
+	const float step = (cullTo > cullFrom ? 1.0f : -1.0f) / float(GetContext().maxBlockFrames);
+	const float start = cullFrom + step * float(offset);
+	const float left = (cullTo - start) / step;
+
+	int32_t ramp = left > 0.0f ? int32_t(left) : 0;
+	ramp = ramp < output.frames ? ramp : output.frames;
+	if (ramp > 0)
+		AudioMix::MultiplyRamp(output.Slice(0, ramp), start, step);
+
+	if (cullTo == 0.0f && ramp < output.frames)
+		AudioMix::Zero(output.Slice(ramp, output.frames - ramp));
+}
+
+bool Base::TrackPeak(const AudioBuffer & output)
+{
+	const auto & context = GetContext();
+	if (done || context.retireLevel <= 0.0f || context.retireFrames <= 0)
+		return done;
+
+	// only what was written can be loud; the rest of output is someone
+	// else's, or silence
+	const int32_t end = written.end < output.frames ? written.end : output.frames;
+	const FrameRange range(written.begin, end);
+	peak = range.IsSilent() ? 0.0f : AudioMix::Peak(output.Slice(range.begin, range.GetFrames()));
+	quietFrames = peak < context.retireLevel ? quietFrames + output.frames : 0;
+
+	// CanRetire can walk a subtree, so it's only asked once the output has
+	// been quiet long enough to matter
+	if (quietFrames >= context.retireFrames && CanRetire())
+		done = true;
+
+	return done;
+}
+
+}
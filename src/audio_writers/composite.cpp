@@ -6,7 +6,9 @@
 //
 
 #include "audio_writers.h"
-#include "audio_module.h"
+#include "audio_mix.h"
+#include <stdlib.h>
+#include <string.h>
 
 namespace AudioWriter
 {
@@ -20,10 +22,11 @@ bool Composite::Init()
 		child->Init();
 	}
 	
-	// set up some scratch space for mixing children
-	scratchLen = 2 * 48000 * sizeof(float);
-	scratchSpace = (float*) malloc(scratchLen);
-	memset(scratchSpace, 0, scratchLen);
+	// set up some scratch space for mixing children, big enough for the
+	// largest block at whatever rate we're running
+	const auto & context = GetContext();
+	scratchFrames = context.maxBlockFrames;
+	scratchSpace = AudioBuffer::Allocate(scratchFrames, context.channels);
 	
 	return done;
 }
@@ -37,21 +40,61 @@ bool Composite::DetermineDone()
 	return donetest;
 }
 
-bool Composite::Write(float *buffer, int32_t numFrames)
+bool Composite::Write(const AudioBuffer & buffer)
 {
-	const auto & context = AudioSubmodule::Instance()->GetContext();
+	const int32_t numFrames = buffer.frames;
+	
+	// a block bigger than the scratch goes through in pieces
+	if (numFrames > scratchFrames)
+	{
+		FrameRange total;
+		for (int32_t start = 0; start < numFrames; start += scratchFrames)
+		{
+			Write(buffer.Slice(start, numFrames - start < scratchFrames ? numFrames - start : scratchFrames));
+			total.Include(written, start);
+		}
+		
+		written = total;
+		return done;
+	}
+	
+	const auto & context = GetContext();
 	const float hertz = float(context.hertz);
 	const float timeJump = float (numFrames) / hertz;
 	
+	// children render in the same layout they'll be mixed into
+	const AudioBuffer scratch = buffer.SameLayout(scratchSpace, numFrames, scratchFrames);
+	
+	written = FrameRange();
 	for (auto * child : children)
 	{
-		memset(scratchSpace, 0, scratchLen);
-		child->Write(scratchSpace, numFrames);
+		// finished or retired children are left alone, so a retired one
+		// can't pick its clock back up
+		if (child->done)
+			continue;
 		
-		for ( int32_t c = 0 ; c < numFrames; c++ )
+		// culled layers keep time but cost next to nothing, once they've
+		// faded out
+		if (child->SkipCulled(numFrames))
 		{
-			buffer[c] += scratchSpace[c];
+			child->Skip(numFrames);
+			continue;
 		}
+		
+		// the scratch is kept zeroed between children, so only what a
+		// child wrote needs mixing in and clearing back out
+		child->Write(scratch);
+		child->TrackPeak(scratch);
+		
+		const FrameRange & range = child->written;
+		if (range.IsSilent())
+			continue;
+		
+		const AudioBuffer childOut = scratch.Slice(range.begin, range.GetFrames());
+		child->FadeCull(childOut, range.begin);
+		AudioMix::Add(buffer.Slice(range.begin, range.GetFrames()), childOut);
+		AudioMix::Zero(childOut);
+		written.Include(range);
 	}
 
 	time += timeJump;
@@ -59,6 +102,70 @@ bool Composite::Write(float *buffer, int32_t numFrames)
 	return done;
 }
 
+bool Composite::Skip(int32_t numFrames)
+{
+	const float hertz = float(GetContext().hertz);
+	
+	for (auto * child : children)
+	{
+		if (!child->done)
+			child->Skip(numFrames);
+	}
+	
+	time += float (numFrames) / hertz;
+	done = DetermineDone();
+	return done;
+}
+
+bool Composite::Rewind()
+{
+	Base::Rewind();
+	
+	bool rewound = true;
+	for (auto * child : children)
+		rewound &= child->Rewind();
+	
+	return rewound;
+}
+
+float Composite::GetLevel() const
+{
+	float level = 0.0f;
+	for (auto * child : children)
+	{
+		if (!child->done)
+			level += child->GetLevel();
+	}
+	
+	return level;
+}
+
+bool Composite::CanRetire() const
+{
+	if (!Base::CanRetire())
+		return false;
+	
+	for (auto * child : children)
+	{
+		if (!child->done && !child->CanRetire())
+			return false;
+	}
+	
+	return true;
+}
+
+int32_t Composite::GetLatencyFrames() const
+{
+	int32_t latency = 0;
+	for (auto * child : children)
+	{
+		const int32_t childLatency = child->GetLatencyFrames();
+		latency = childLatency > latency ? childLatency : latency;
+	}
+	
+	return latency;
+}
+
 void Composite::PushChild(Base * child)
 {
 	children.push_back(child);
@@ -71,7 +178,7 @@ Composite::~Composite()
 		delete child;
 	}
 	
-	free(scratchSpace);
+	AudioBuffer::Free(scratchSpace);
 }
 
 }
@@ -0,0 +1,38 @@
+//
+//  context.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+
+namespace AudioWriter
+{
+
+static Context sContext;
+
+// set by a ContextScope while a subtree renders at its own format
+static thread_local const Context * sOverride = nullptr;
+
+const Context & GetContext()
+{
+	return sOverride ? *sOverride : sContext;
+}
+
+void SetContext(const Context & context)
+{
+	sContext = context;
+}
+
+ContextScope::ContextScope(const Context & scopeContext) :
+	context(scopeContext),
+	previous(sOverride)
+{
+	sOverride = &context;
+}
+
+ContextScope::~ContextScope()
+{
+	sOverride = previous;
+}
+
+}
@@ -6,12 +6,15 @@
 //
 
 #include "audio_writers.h"
-#include "audio_module.h"
+#include "audio_mix.h"
 #include <math.h>
 
 namespace AudioWriter
 {
 
+// frames between evaluations of the envelope curve
+static const int32_t kControlFrames = 32;
+
 float SineEnvelope::operator () (float t)
 {
 	// multiply by the segment of sine from 0 to PI
@@ -44,6 +47,16 @@ float AttackSustainDecayEnvelope::operator () (float t)
 	return (1.0f - t) * 5.0f;
 }
 
+float PluckEnvelope::operator () (float t)
+{
+	// a click free attack over the first 1%, then a fall of about
+	// 170 dB over the rest
+	if (t < 0.01f)
+		return t * 100.0f;
+	
+	return expf(-20.0f * (t - 0.01f));
+}
+
 bool Envelope::Init()
 {
 	inited = true;
@@ -61,27 +74,120 @@ bool Envelope::Init()
 	return done;
 }
 
-bool Envelope::Write(float *buffer, int32_t numFrames)
+bool Envelope::Write(const AudioBuffer & buffer)
 {
-	const auto context = AudioSubmodule::Instance()->GetContext();
+	const auto context = GetContext();
 	const float hertz = float(context.hertz);
+	const int32_t numFrames = buffer.frames;
 	
-	done = child->Write(buffer, numFrames);
+	done = child->Write(buffer);
+	written = child->written;
 	
-	float timeStep = 1.0f / hertz;
-	if (envelope)
+	// the curve is evaluated once per control period and ramped between,
+	// rather than a virtual call per frame; like Tone, time each point
+	// from the start of the block so the curve doesn't drift at high rates.
+	// Each lod doubles the period.  Only what the child wrote is shaped;
+	// the rest of buffer isn't ours to touch.
+	const double startTime = time;
+	if (envelope && !written.IsSilent())
 	{
-		for (int32_t frame = 0; frame < numFrames; time += timeStep, frame++)
+		const int32_t controlFrames = kControlFrames << (context.lod < kMaxLod ? context.lod : kMaxLod);
+		float value = (*envelope)(float(startTime) / duration);
+		for (int32_t frame = 0; frame < written.end; frame += controlFrames)
 		{
-			float t = time / duration;
-			float value = (*envelope)(t);
-			buffer[frame] = value * buffer[frame];
+			int32_t frames = numFrames - frame;
+			if (frames > controlFrames)
+				frames = controlFrames;
+			
+			const float t = float(startTime + double(frame + frames) / double(hertz)) / duration;
+			const float next = (*envelope)(t);
+			const float step = (next - value) / float(frames);
+			
+			const int32_t first = written.begin > frame ? written.begin : frame;
+			const int32_t last = written.end < frame + frames ? written.end : frame + frames;
+			if (first < last)
+				AudioMix::MultiplyRamp(buffer.Slice(first, last - first), value + step * float(first - frame), step);
+			value = next;
 		}
 	}
 	
+	// the curve runs over the whole block either way, to keep its place
+	if (automation)
+	{
+		for (int32_t start = 0; start < numFrames; start += automation->capacity)
+		{
+			int32_t frames = numFrames - start;
+			if (frames > automation->capacity)
+				frames = automation->capacity;
+			
+			automation->Render(frames);
+			
+			const int32_t first = written.begin > start ? written.begin : start;
+			const int32_t last = written.end < start + frames ? written.end : start + frames;
+			if (first < last)
+				AudioMix::Multiply(buffer.Slice(first, last - first), automation->gainCurve + first - start);
+		}
+	}
+	
+	time = float(startTime + double(numFrames) / double(hertz));
+	
+	return done;
+}
+
+bool Envelope::Skip(int32_t numFrames)
+{
+	const double hertz = double(GetContext().hertz);
+	
+	done = child->Skip(numFrames);
+	if (automation)
+		automation->Skip(numFrames);
+	
+	time = float(double(time) + double(numFrames) / hertz);
 	return done;
 }
 
+bool Envelope::Rewind()
+{
+	Base::Rewind();
+	if (!child)
+	{
+		done = true;
+		return true;
+	}
+	
+	child->gain = gain;
+	child->phase = phase;
+	child->pitch = pitch;
+	child->duration = duration;
+	
+	return child->Rewind();
+}
+
+float Envelope::GetLevel() const
+{
+	if (!child)
+		return 0.0f;
+	
+	float level = child->GetLevel();
+	
+	if (envelope && duration > 0.0f)
+	{
+		const auto & context = GetContext();
+		const float ahead = float(context.maxBlockFrames) / float(context.hertz);
+		const float now = time / duration;
+		const float next = (time + ahead) / duration;
+		
+		const float current = fabsf((*envelope)(now < 1.0f ? now : 1.0f));
+		const float upcoming = fabsf((*envelope)(next < 1.0f ? next : 1.0f));
+		level *= current > upcoming ? current : upcoming;
+	}
+	
+	if (automation)
+		level *= automation->gain.GetValue();
+	
+	return level;
+}
+
 Envelope::~Envelope()
 {
 	delete envelope;
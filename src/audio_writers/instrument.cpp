@@ -0,0 +1,421 @@
+//
+//  instrument.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_mix.h"
+
+namespace AudioWriter
+{
+
+void Instrument::AddVoice(Base * voice)
+{
+	if (!voice)
+		return;
+
+	Voice added;
+	added.root = voice;
+	voices.push_back(added);
+	heldNotes.reserve(voices.size());
+}
+
+void Instrument::PushNote(const Note & note)
+{
+	// kept in start order; a note at the same time as another lands after it
+	auto it = notes.end();
+	while (it != notes.begin() && (it - 1)->start > note.start)
+		--it;
+
+	notes.insert(it, note);
+}
+
+bool Instrument::Init()
+{
+	inited = true;
+
+	const auto & context = GetContext();
+	hertz = context.hertz;
+
+	// every voice is built and initialized now, so a note only rewinds one
+	for (auto & voice : voices)
+		voice.root->Init();
+
+	// both lists hold every voice at most, so neither grows while playing;
+	// the free list hands out voice 0 first
+	freeVoices.clear();
+	freeVoices.reserve(voices.size());
+	for (int32_t index = int32_t(voices.size()) - 1; index >= 0; index--)
+		freeVoices.push_back(index);
+
+	active.clear();
+	active.reserve(voices.size());
+
+	// zeroed once; a voice's output is cleared back out after mixing
+	scratchFrames = context.maxBlockFrames;
+	scratchSpace = AudioBuffer::Allocate(scratchFrames, context.channels);
+
+	if (duration <= 0.0f)
+	{
+		for (const auto & note : notes)
+			duration = note.start + note.duration > duration ? note.start + note.duration : duration;
+	}
+
+	nextNote = 0;
+	frame = 0;
+
+	for (const auto & held : heldNotes)
+		StartNote(held, 0);
+	heldNotes.clear();
+
+	done = voices.empty();
+	return done;
+}
+
+void Instrument::NoteOn(const Note & note)
+{
+	// stamped with now, so stealing can tell it from older pending notes
+	Note live = note;
+	live.start = time;
+
+	// the mixer applies a note posted with the stream's Start before the
+	// first block has initialized anything, so there are no voices to
+	// hand out yet
+	if (!inited)
+	{
+		if (heldNotes.size() < heldNotes.capacity())
+			heldNotes.push_back(live);
+		else
+			droppedNotes++;
+		return;
+	}
+
+	StartNote(live, frame);
+}
+
+bool Instrument::Write(const AudioBuffer & buffer)
+{
+	written = FrameRange();
+	if (done)
+		return done;
+
+	// a block bigger than the scratch goes through in pieces
+	const int32_t numFrames = buffer.frames;
+	for (int32_t start = 0; start < numFrames; start += scratchFrames)
+	{
+		const AudioBuffer piece = buffer.Slice(start, numFrames - start < scratchFrames ? numFrames - start : scratchFrames);
+		written.Include(Process(&piece, piece.frames), start);
+	}
+
+	return done;
+}
+
+bool Instrument::Skip(int32_t numFrames)
+{
+	if (done)
+		return done;
+
+	for (int32_t start = 0; start < numFrames; start += scratchFrames)
+		Process(nullptr, numFrames - start < scratchFrames ? numFrames - start : scratchFrames);
+
+	return done;
+}
+
+// renders into buffer, or skips with no buffer, cutting the block at
+// every note start and at the end of every steal's fade, so voices only
+// change hands between pieces; returns the frames written to
+FrameRange Instrument::Process(const AudioBuffer * buffer, int32_t numFrames)
+{
+	FrameRange range;
+	int32_t cursor = 0;
+	while (cursor < numFrames)
+	{
+		const int64_t now = frame + cursor;
+		while (nextNote < notes.size() && NoteFrame(notes[nextNote]) <= now)
+			StartNote(notes[nextNote++], now);
+
+		int32_t frames = numFrames - cursor;
+		if (nextNote < notes.size() && NoteFrame(notes[nextNote]) - now < frames)
+			frames = int32_t(NoteFrame(notes[nextNote]) - now);
+
+		for (int32_t index : active)
+		{
+			const Voice & voice = voices[index];
+			if (voice.stealing && voice.fadeFrames < frames)
+				frames = voice.fadeFrames;
+		}
+
+		if (buffer)
+		{
+			const AudioBuffer piece = buffer->Slice(cursor, frames);
+			range.Include(RenderVoices(&piece, frames, now + frames), cursor);
+		}
+		else
+			RenderVoices(nullptr, frames, now + frames);
+		cursor += frames;
+	}
+
+	frame += numFrames;
+	time = float(double(frame) / double(hertz));
+	done = duration > 0.0f && time >= duration && active.empty() && nextNote >= notes.size();
+	return range;
+}
+
+FrameRange Instrument::RenderVoices(const AudioBuffer * buffer, int32_t numFrames, int64_t endFrame)
+{
+	FrameRange range;
+	const AudioBuffer scratch = buffer ? buffer->SameLayout(scratchSpace, numFrames, scratchFrames) : AudioBuffer();
+	for (size_t a = 0; a < active.size(); )
+	{
+		const int32_t index = active[a];
+		Voice & voice = voices[index];
+		Base * root = voice.root;
+
+		const bool playing = !root->done;
+		if (playing && buffer && !root->SkipCulled(numFrames))
+		{
+			root->Write(scratch);
+			root->TrackPeak(scratch);
+
+			// only what the voice wrote is faded, mixed and cleared back out
+			const FrameRange & voiceRange = root->written;
+			if (!voiceRange.IsSilent())
+			{
+				const AudioBuffer voiceOut = scratch.Slice(voiceRange.begin, voiceRange.GetFrames());
+				root->FadeCull(voiceOut, voiceRange.begin);
+				if (voice.stealing)
+				{
+					const float fadeStep = 1.0f / float(stealFrames);
+					AudioMix::MultiplyRamp(voiceOut, float(voice.fadeFrames - voiceRange.begin) * fadeStep, -fadeStep);
+				}
+
+				AudioMix::Add(buffer->Slice(voiceRange.begin, voiceRange.GetFrames()), voiceOut);
+				AudioMix::Zero(voiceOut);
+				range.Include(voiceRange);
+			}
+		}
+		else if (playing)
+		{
+			root->Skip(numFrames);
+		}
+
+		if (voice.stealing)
+		{
+			voice.fadeFrames -= numFrames;
+
+			// faded out, or finished on its own first; the note it was
+			// stolen for starts on it right away
+			if (voice.fadeFrames <= 0 || root->done)
+			{
+				const Note note = voice.pending;
+				Begin(index, note, endFrame);
+			}
+
+			a++;
+			continue;
+		}
+
+		if (root->done)
+		{
+			freeVoices.push_back(index);
+			active[a] = active.back();
+			active.pop_back();
+			continue;
+		}
+
+		a++;
+	}
+
+	return range;
+}
+
+void Instrument::StartNote(const Note & note, int64_t startFrame)
+{
+	if (!freeVoices.empty())
+	{
+		const int32_t index = freeVoices.back();
+		freeVoices.pop_back();
+
+		Begin(index, note, startFrame);
+		active.push_back(index);
+		return;
+	}
+
+	const int32_t victim = PickVictim();
+	if (victim >= 0)
+	{
+		stolenNotes++;
+
+		if (stealFrames <= 0)
+		{
+			Begin(victim, note, startFrame);
+			return;
+		}
+
+		Voice & voice = voices[victim];
+		voice.stealing = true;
+		voice.fadeFrames = stealFrames;
+		voice.pending = note;
+		return;
+	}
+
+	// every voice is already fading out for a note of its own; the newest
+	// note takes over from the oldest one waiting
+	droppedNotes++;
+
+	int32_t oldest = -1;
+	for (int32_t index : active)
+	{
+		if (oldest < 0 || voices[index].pending.start < voices[oldest].pending.start)
+			oldest = index;
+	}
+
+	if (oldest >= 0)
+		voices[oldest].pending = note;
+}
+
+void Instrument::Begin(int32_t index, const Note & note, int64_t startFrame)
+{
+	Voice & voice = voices[index];
+	voice.stealing = false;
+	voice.fadeFrames = 0;
+	voice.startFrame = startFrame;
+
+	// the note's params go on before the rewind, which is what hands them
+	// down to the child of an Envelope or ParamOverride voice
+	Base * root = voice.root;
+	if (!tune)
+	{
+		root->pitch = note.pitch;
+		root->gain = note.gain;
+		root->duration = note.duration;
+	}
+
+	if (!root->Rewind())
+	{
+		// can't play again, so it goes straight back on the free list
+		root->done = true;
+		return;
+	}
+
+	if (tune)
+		tune(root, note);
+}
+
+// a playing voice that isn't already being stolen, or -1
+int32_t Instrument::PickVictim() const
+{
+	int32_t victim = -1;
+	float victimLevel = 0.0f;
+
+	for (int32_t index : active)
+	{
+		const Voice & voice = voices[index];
+		if (voice.stealing)
+			continue;
+
+		if (steal == kStealQuietest)
+		{
+			const float level = voice.root->done ? 0.0f : voice.root->GetLevel();
+			if (victim < 0 || level < victimLevel)
+			{
+				victim = index;
+				victimLevel = level;
+			}
+		}
+		else if (victim < 0 || voice.startFrame < voices[victim].startFrame)
+		{
+			victim = index;
+		}
+	}
+
+	return victim;
+}
+
+int64_t Instrument::NoteFrame(const Note & note) const
+{
+	return int64_t(double(note.start) * double(hertz));
+}
+
+bool Instrument::Rewind()
+{
+	Base::Rewind();
+
+	bool rewound = true;
+	for (auto & voice : voices)
+	{
+		rewound &= voice.root->Rewind();
+		voice.stealing = false;
+		voice.fadeFrames = 0;
+	}
+
+	freeVoices.clear();
+	for (int32_t index = int32_t(voices.size()) - 1; index >= 0; index--)
+		freeVoices.push_back(index);
+	active.clear();
+
+	nextNote = 0;
+	frame = 0;
+	done = voices.empty();
+	return rewound;
+}
+
+float Instrument::GetLevel() const
+{
+	float level = 0.0f;
+	for (int32_t index : active)
+	{
+		const Voice & voice = voices[index];
+		if (voice.root->done)
+			continue;
+
+		float voiceLevel = voice.root->GetLevel();
+		if (voice.stealing)
+			voiceLevel *= float(voice.fadeFrames) / float(stealFrames);
+		level += voiceLevel;
+	}
+
+	const auto & context = GetContext();
+	const float ahead = float(context.maxBlockFrames) / float(context.hertz);
+	if (nextNote < notes.size() && notes[nextNote].start < time + ahead)
+		level += notes[nextNote].gain;
+
+	return level;
+}
+
+bool Instrument::CanRetire() const
+{
+	if (!Base::CanRetire() || duration <= 0.0f || nextNote < notes.size())
+		return false;
+
+	for (int32_t index : active)
+	{
+		const Voice & voice = voices[index];
+		if (voice.stealing || (!voice.root->done && !voice.root->CanRetire()))
+			return false;
+	}
+
+	return true;
+}
+
+int32_t Instrument::GetLatencyFrames() const
+{
+	int32_t latency = 0;
+	for (const auto & voice : voices)
+	{
+		const int32_t voiceLatency = voice.root->GetLatencyFrames();
+		latency = voiceLatency > latency ? voiceLatency : latency;
+	}
+
+	return latency;
+}
+
+Instrument::~Instrument()
+{
+	for (auto & voice : voices)
+		delete voice.root;
+
+	AudioBuffer::Free(scratchSpace);
+}
+
+}
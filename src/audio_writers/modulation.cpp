@@ -0,0 +1,121 @@
+//
+//  modulation.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_mix.h"
+#include <math.h>
+
+namespace AudioWriter
+{
+
+float Lfo::Evaluate(double time)
+{
+	return wave ? wave(float(time), rate, phase) : 0.0f;
+}
+
+float ModEnvelope::Evaluate(double time)
+{
+	if (!envelope || duration <= 0.0f)
+		return 0.0f;
+
+	float t = float(time) / duration;
+	if (t > 1.0f)
+		t = 1.0f;
+
+	return (*envelope)(t);
+}
+
+int32_t Modulation::AddSource(ModSource * source)
+{
+	sources.push_back(source);
+	return int32_t(sources.size()) - 1;
+}
+
+void Modulation::AddRoute(int32_t source, Destination destination, float depth)
+{
+	routes.push_back(Route { source, destination, depth });
+}
+
+void Modulation::Evaluate(float & gain, float & pitch) const
+{
+	gain = 1.0f;
+	float semitones = 0.0f;
+
+	for (const auto & route : routes)
+	{
+		const float value = sources[route.source]->Evaluate(time) * route.depth;
+		if (route.destination == kGain)
+			gain *= 1.0f + value;
+		else
+			semitones += value;
+	}
+
+	pitch = exp2f(semitones / 12.0f);
+}
+
+// moves on to the next control period; the first call also evaluates the
+// start, so the first period ramps from time zero
+void Modulation::Advance()
+{
+	if (!primed)
+	{
+		Evaluate(gainNext, pitchNext);
+		primed = true;
+	}
+
+	gainPrevious = gainNext;
+	pitchPrevious = pitchNext;
+
+	time += double(controlFrames) / double(GetContext().hertz);
+	Evaluate(gainNext, pitchNext);
+
+	controlPosition = 0;
+}
+
+void Modulation::Apply(float * gainCurve, float * pitchCurve, int32_t numFrames)
+{
+	if (routes.empty() || controlFrames <= 0)
+		return;
+
+	if (!primed)
+		controlPosition = controlFrames;
+
+	int32_t cursor = 0;
+	while (cursor < numFrames)
+	{
+		if (controlPosition >= controlFrames)
+			Advance();
+
+		int32_t frames = controlFrames - controlPosition;
+		if (frames > numFrames - cursor)
+			frames = numFrames - cursor;
+
+		// pick the line up where the last block left it
+		const float period = float(controlFrames);
+		const float gainStep = (gainNext - gainPrevious) / period;
+		const float pitchStep = (pitchNext - pitchPrevious) / period;
+
+		AudioMix::MultiplyRamp(gainCurve + cursor, gainPrevious + gainStep * float(controlPosition), gainStep, frames);
+		AudioMix::MultiplyRamp(pitchCurve + cursor, pitchPrevious + pitchStep * float(controlPosition), pitchStep, frames);
+
+		controlPosition += frames;
+		cursor += frames;
+	}
+}
+
+void Modulation::Rewind()
+{
+	time = 0.0;
+	primed = false;
+	controlPosition = 0;
+}
+
+Modulation::~Modulation()
+{
+	for (auto * source : sources)
+		delete source;
+}
+
+}
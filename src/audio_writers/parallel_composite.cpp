@@ -0,0 +1,127 @@
+//
+//  parallel_composite.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_mix.h"
+#include "job_pool.h"
+
+namespace AudioWriter
+{
+
+bool ParallelComposite::Init()
+{
+	Composite::Init();
+
+	JobPool * pool = JobPool::Instance();
+	workers = pool ? pool->GetNumWorkers() : 1;
+	workerWritten.assign(workers, FrameRange());
+
+	// a sum and a render target per worker, each a block of every
+	// channel, back to back
+	const auto & context = GetContext();
+	workerFrames = context.maxBlockFrames;
+	workerSpace = AudioBuffer::Allocate(workerFrames, 2 * workers * context.channels);
+
+	return done;
+}
+
+void ParallelComposite::RenderChild(void * userData, int32_t task, int32_t worker)
+{
+	ParallelComposite * self = (ParallelComposite *) userData;
+	ContextScope scope(self->blockContext);
+
+	Base * child = self->children[task];
+	if (child->done)
+		return;
+
+	const AudioBuffer & block = self->block;
+	if (child->SkipCulled(block.frames))
+	{
+		child->Skip(block.frames);
+		return;
+	}
+
+	const AudioBuffer sum = self->GetWorkerBuffer(worker, 0);
+	const AudioBuffer scratch = self->GetWorkerBuffer(worker, 1);
+
+	child->Write(scratch);
+	child->TrackPeak(scratch);
+
+	// as in Composite, only what the child wrote is summed and cleared
+	const FrameRange & range = child->written;
+	if (range.IsSilent())
+		return;
+
+	const AudioBuffer childOut = scratch.Slice(range.begin, range.GetFrames());
+	child->FadeCull(childOut, range.begin);
+	AudioMix::Add(sum.Slice(range.begin, range.GetFrames()), childOut);
+	AudioMix::Zero(childOut);
+	self->workerWritten[worker].Include(range);
+}
+
+// worker's sum, 0, or render target, 1, laid out like the block
+AudioBuffer ParallelComposite::GetWorkerBuffer(int32_t worker, int32_t index) const
+{
+	const size_t bufferLen = size_t(AudioBuffer::GetPlaneStride(workerFrames)) * block.channels;
+	return block.SameLayout(workerSpace + (2 * worker + index) * bufferLen, block.frames, workerFrames);
+}
+
+bool ParallelComposite::Write(const AudioBuffer & buffer)
+{
+	JobPool * pool = JobPool::Instance();
+	const int32_t numFrames = buffer.frames;
+	const int64_t work = int64_t(children.size()) * numFrames;
+
+	if (!pool || pool->GetNumWorkers() != workers || workers == 1 || work < parallelThreshold)
+		return Composite::Write(buffer);
+
+	const auto & context = GetContext();
+
+	// a block bigger than the worker buffers goes through in pieces
+	if (numFrames > workerFrames)
+	{
+		FrameRange total;
+		for (int32_t start = 0; start < numFrames; start += workerFrames)
+		{
+			Write(buffer.Slice(start, numFrames - start < workerFrames ? numFrames - start : workerFrames));
+			total.Include(written, start);
+		}
+
+		written = total;
+		return done;
+	}
+
+	blockContext = context;
+	block = buffer;
+
+	pool->ParallelFor(RenderChild, this, int32_t(children.size()));
+
+	// fold every worker's sum into the output, leaving the sums zeroed
+	// for the next block
+	written = FrameRange();
+	for (int32_t w = 0; w < workers; w++)
+	{
+		FrameRange & range = workerWritten[w];
+		if (range.IsSilent())
+			continue;
+
+		const AudioBuffer sum = GetWorkerBuffer(w, 0).Slice(range.begin, range.GetFrames());
+		AudioMix::Add(buffer.Slice(range.begin, range.GetFrames()), sum);
+		AudioMix::Zero(sum);
+		written.Include(range);
+		range = FrameRange();
+	}
+
+	time += float(numFrames) / float(context.hertz);
+	done = DetermineDone();
+	return done;
+}
+
+ParallelComposite::~ParallelComposite()
+{
+	AudioBuffer::Free(workerSpace);
+}
+
+}
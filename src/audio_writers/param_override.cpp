@@ -6,7 +6,6 @@
 //
 
 #include "audio_writers.h"
-#include "audio_module.h"
 
 namespace AudioWriter
 {
@@ -35,17 +34,18 @@ void ParamOverride::CopyParams()
 	child->duration = duration;
 }
 
-bool ParamOverride::Write(float * buffer, int32_t numFrames)
+bool ParamOverride::Write(const AudioBuffer & buffer)
 {
 	CopyParams();
 	
-	const auto & context = AudioSubmodule::Instance()->GetContext();
+	const auto & context = GetContext();
 	const float hertz = float(context.hertz);
+	const int32_t numFrames = buffer.frames;
 	
 	const float timeStep = float (numFrames) / hertz;
 	
-	float * writeBuffer = buffer;
 	int32_t writeFrames = numFrames;
+	written = FrameRange();
 	
 	if (time < delay)
 	{
@@ -56,17 +56,47 @@ bool ParamOverride::Write(float * buffer, int32_t numFrames)
 			writeFrames = int32_t(writeStep * hertz);
 			
 			int32_t writeStart = numFrames - writeFrames;
-			
-			// for right now we are developing assuming mono; at some
-			// point we will want to fix that.
-			int32_t channels = 1;
-			writeBuffer = buffer + (writeStart * channels);
-			child->Write(writeBuffer, writeFrames);
+			child->Write(buffer.Slice(writeStart, writeFrames));
+			written.Include(child->written, writeStart);
 		}
 	}
 	else
 	{
-		done = child->Write(writeBuffer, writeFrames);
+		done = child->Write(buffer);
+		written = child->written;
+	}
+	time += timeStep;
+	return done;
+}
+
+bool ParamOverride::Rewind()
+{
+	Base::Rewind();
+	if (!child)
+	{
+		done = true;
+		return true;
+	}
+	
+	CopyParams();
+	return child->Rewind();
+}
+
+bool ParamOverride::Skip(int32_t numFrames)
+{
+	CopyParams();
+	
+	const float hertz = float(GetContext().hertz);
+	const float timeStep = float (numFrames) / hertz;
+	
+	if (time < delay)
+	{
+		if (time + timeStep > delay)
+			child->Skip(int32_t((timeStep - (delay - time)) * hertz));
+	}
+	else
+	{
+		done = child->Skip(numFrames);
 	}
 	time += timeStep;
 	return done;
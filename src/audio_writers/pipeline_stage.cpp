@@ -0,0 +1,252 @@
+//
+//  pipeline_stage.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_mix.h"
+
+namespace AudioWriter
+{
+
+PipelineStage::PipelineStage(Base * stageChild, int32_t latency) :
+	child(stageChild)
+{
+	const auto & context = GetContext();
+	channels = context.channels;
+	latencyFrames = latency > 0 ? latency : context.maxBlockFrames;
+	stageContext = context;
+	setupThread = context.setupThread;
+	setupData = context.setupData;
+
+	ring.Init(uint32_t(latencyFrames * channels));
+	stageSpace = AudioBuffer::Allocate(latencyFrames, channels);
+	readSpace = AudioBuffer::Allocate(latencyFrames, channels);
+
+	running.store(true, std::memory_order_release);
+	if (!thread.init(ThreadFunc, this, 0, "pipeline stage"))
+		running.store(false, std::memory_order_release);
+}
+
+int32_t PipelineStage::ThreadFunc(bx::Thread * self, void * userData)
+{
+	((PipelineStage *) userData)->Run();
+	return 0;
+}
+
+void PipelineStage::Run()
+{
+	if (setupThread)
+		setupThread(setupData);
+
+	for (;;)
+	{
+		wake.wait();
+		if (!running.load(std::memory_order_acquire))
+			break;
+
+		ContextScope scope(stageContext);
+		Render(requested.load(std::memory_order_acquire));
+		rendered.post();
+	}
+}
+
+// blocks rather than spins on the block rendered ahead last time, which
+// is normally long finished; a realtime mixer yielding in a loop would
+// never let a stage thread sharing its core run
+void PipelineStage::WaitForStage()
+{
+	if (rendering)
+	{
+		rendered.wait();
+		rendering = false;
+	}
+}
+
+// tops the ring up by numFrames, stopping early if the child finishes
+void PipelineStage::Render(int32_t numFrames)
+{
+	for (int32_t start = 0; start < numFrames && !child->done; start += latencyFrames)
+	{
+		int32_t frames = numFrames - start;
+		if (frames > latencyFrames)
+			frames = latencyFrames;
+
+		// interleaved, the way the ring holds it
+		const AudioBuffer stage(stageSpace, frames, channels);
+		AudioMix::Zero(stage);
+		child->Write(stage);
+		child->TrackPeak(stage);
+		ring.Write(stageSpace, uint32_t(frames * channels));
+	}
+}
+
+bool PipelineStage::Init()
+{
+	inited = true;
+	if (!child)
+	{
+		done = true;
+		return done;
+	}
+
+	child->Init();
+
+	// the declared latency, as silence up front
+	ring.Reset();
+	AudioMix::Zero(stageSpace, latencyFrames * channels);
+	ring.Write(stageSpace, uint32_t(latencyFrames * channels));
+
+	childLevel = child->GetLevel();
+	done = false;
+	return done;
+}
+
+bool PipelineStage::Write(const AudioBuffer & buffer)
+{
+	const auto & context = GetContext();
+	const int32_t numFrames = buffer.frames;
+	written = FrameRange();
+
+	if (!child)
+	{
+		done = true;
+		return done;
+	}
+
+	WaitForStage();
+
+	const bool childDone = child->done;
+	childLevel = child->GetLevel();
+	childRetires = childDone;
+
+	int32_t cursor = 0;
+	while (cursor < numFrames)
+	{
+		int32_t frames = numFrames - cursor;
+		if (frames > latencyFrames)
+			frames = latencyFrames;
+
+		const uint32_t read = ring.Read(readSpace, uint32_t(frames * channels));
+		if (read == 0)
+			break;
+
+		const int32_t readFrames = int32_t(read) / channels;
+		AudioMix::Add(buffer.Slice(cursor, readFrames), AudioBuffer(readSpace, readFrames, channels));
+		cursor += readFrames;
+	}
+
+	// asked for more than the stage holds; render the rest here, in order,
+	// since the stage thread is idle
+	while (cursor < numFrames && !child->done)
+	{
+		int32_t frames = numFrames - cursor;
+		if (frames > latencyFrames)
+			frames = latencyFrames;
+
+		const AudioBuffer stage(stageSpace, frames, channels);
+		AudioMix::Zero(stage);
+		child->Write(stage);
+		child->TrackPeak(stage);
+		AudioMix::Add(buffer.Slice(cursor, frames), stage);
+		cursor += frames;
+	}
+
+	// the ring holds the child's whole blocks, silent stretches and all,
+	// so the stage can only vouch for having written up to where it ran dry
+	written = FrameRange(0, cursor);
+	time += float(numFrames) / float(context.hertz);
+
+	const int32_t owed = latencyFrames - int32_t(ring.GetAvailable()) / channels;
+	if (!child->done && owed > 0 && running.load(std::memory_order_relaxed))
+	{
+		stageContext = context;
+		requested.store(owed, std::memory_order_release);
+		rendering = true;
+		wake.post();
+	}
+	else if (!running.load(std::memory_order_relaxed))
+	{
+		// no thread to run on, so it's a plain serial chain with a delay
+		Render(owed);
+	}
+
+	done = childDone && ring.GetAvailable() == 0;
+	return done;
+}
+
+bool PipelineStage::Skip(int32_t numFrames)
+{
+	const auto & context = GetContext();
+
+	if (!child)
+	{
+		done = true;
+		return done;
+	}
+
+	WaitForStage();
+
+	childLevel = child->GetLevel();
+	childRetires = child->done;
+
+	// whatever was rendered ahead covers the start of the skip; the child
+	// skips the rest, plus what the ring is now short, which goes in as
+	// silence so the stage stays latencyFrames deep
+	const int32_t dropped = int32_t(ring.Skip(uint32_t(numFrames * channels))) / channels;
+	const int32_t owed = latencyFrames - int32_t(ring.GetAvailable()) / channels;
+
+	if (!child->done)
+	{
+		child->Skip(numFrames - dropped + owed);
+
+		AudioMix::Zero(stageSpace, latencyFrames * channels);
+		ring.Write(stageSpace, uint32_t(owed * channels));
+	}
+
+	time += float(numFrames) / float(context.hertz);
+	done = child->done && ring.GetAvailable() == 0;
+	return done;
+}
+
+bool PipelineStage::Rewind()
+{
+	Base::Rewind();
+	if (!child)
+	{
+		done = true;
+		return true;
+	}
+
+	WaitForStage();
+
+	const bool rewound = child->Rewind();
+
+	ring.Reset();
+	AudioMix::Zero(stageSpace, latencyFrames * channels);
+	ring.Write(stageSpace, uint32_t(latencyFrames * channels));
+
+	childLevel = child->GetLevel();
+	childRetires = child->done;
+	return rewound;
+}
+
+int32_t PipelineStage::GetLatencyFrames() const
+{
+	return latencyFrames + (child ? child->GetLatencyFrames() : 0);
+}
+
+PipelineStage::~PipelineStage()
+{
+	if (running.exchange(false))
+	{
+		wake.post();
+		thread.shutdown();
+	}
+
+	delete child;
+	AudioBuffer::Free(stageSpace);
+	AudioBuffer::Free(readSpace);
+}
+
+}
@@ -0,0 +1,437 @@
+//
+//  resampler.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include <bx/allocator.h>
+#include <bx/simd_t.h>
+#include <math.h>
+#include <string.h>
+
+namespace AudioWriter
+{
+
+// output frames converted per pass, and the fastest rate supported; the
+// history is sized from both so it never has to grow on the audio thread
+static const int32_t kPassFrames = 512;
+static const float kMaxStep = 8.0f;
+static const float kMinStep = 1.0f / 64.0f;
+
+static const int32_t kMaxTaps = 32;
+static const int32_t kSimdWidth = 4;
+static const size_t kSimdAlign = 16;
+
+struct QualityTier
+{
+	int32_t taps;
+	int32_t phases;
+	float rolloff;
+	bool interpolate;
+};
+
+static const QualityTier kTiers[] =
+{
+	{ 8, 64, 0.85f, false },
+	{ 16, 128, 0.90f, false },
+	{ 32, 256, 0.95f, true },
+};
+
+static bx::DefaultAllocator sAllocator;
+
+static float Sinc(float x)
+{
+	if (fabsf(x) < 1e-6f)
+		return 1.0f;
+	const float px = x * kTau * 0.5f;
+	return sinf(px) / px;
+}
+
+static float Blackman(float x)
+{
+	return 0.42f - 0.5f * cosf(kTau * x) + 0.08f * cosf(2.0f * kTau * x);
+}
+
+static inline float Dot(const float * a, const float * b, int32_t length)
+{
+	bx::simd128_t sum = bx::simd_zero();
+	for (int32_t c = 0; c < length; c += kSimdWidth)
+		sum = bx::simd_madd(bx::simd_ld(a + c), bx::simd_ld(b + c), sum);
+
+	BX_ALIGN_DECL_16(float lanes[kSimdWidth]);
+	bx::simd_st(lanes, sum);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+Resampler::Resampler(Base * resampled, int32_t hertz, Quality tier) :
+	child(resampled),
+	childHertz(hertz),
+	quality(tier)
+{
+}
+
+bool Resampler::Init()
+{
+	inited = true;
+	if (!child)
+	{
+		done = true;
+		return done;
+	}
+
+	const auto & context = GetContext();
+	const QualityTier & tier = kTiers[quality];
+
+	channels = context.channels;
+	taps = tier.taps;
+	phases = tier.phases;
+
+	// one extra phase so interpolation can always look at p + 1
+	kernelStride = taps + kSimdWidth;
+	const int32_t kernelRows = (phases + 1) * kSimdWidth;
+	kernel = (float *) BX_ALIGNED_ALLOC(&sAllocator, kernelRows * kernelStride * sizeof(float), kSimdAlign);
+	memset(kernel, 0, kernelRows * kernelStride * sizeof(float));
+
+	// when going down in rate the cutoff drops with it, or the child's
+	// top octave folds back into the output
+	float step = rate * float(childHertz) / float(context.hertz);
+	const float cutoff = (step > 1.0f ? 1.0f / step : 1.0f) * tier.rolloff;
+
+	float coefficients[kMaxTaps];
+	for (int32_t p = 0; p <= phases; p++)
+	{
+		const float frac = float(p) / float(phases);
+
+		float sum = 0.0f;
+		for (int32_t k = 0; k < taps; k++)
+		{
+			const float t = float(k - (taps / 2 - 1)) - frac;
+			const float window = Blackman((t + float(taps) * 0.5f) / float(taps));
+			coefficients[k] = cutoff * Sinc(cutoff * t) * window;
+			sum += coefficients[k];
+		}
+
+		// unity gain at dc for every phase
+		for (int32_t k = 0; k < taps; k++)
+			coefficients[k] /= sum;
+
+		// the same phase shifted for each possible input alignment
+		for (int32_t shift = 0; shift < kSimdWidth; shift++)
+		{
+			float * row = kernel + (p * kSimdWidth + shift) * kernelStride;
+			memcpy(row + shift, coefficients, taps * sizeof(float));
+		}
+	}
+
+	// a plane per channel, each on AudioBuffer::kAlign
+	historyCapacity = AudioBuffer::GetPlaneStride(int32_t(float(kPassFrames) * kMaxStep) + taps + 4 * kSimdWidth);
+	history = AudioBuffer::Allocate(historyCapacity, channels);
+
+	// lead in with half a window of silence, so output frame 0 is centered
+	// on input frame 0 and nothing is delayed
+	historyFrames = taps / 2 - 1;
+	readPosition = 0.0;
+	childDone = false;
+
+	// the child is asked for at most a history's worth at a time
+	Context childContext = context;
+	childContext.hertz = childHertz;
+	childContext.maxBlockFrames = historyCapacity;
+	ContextScope scope(childContext);
+
+	done = child->Init();
+	childDone = done;
+	return done;
+}
+
+void Resampler::Fill(int32_t neededFrames)
+{
+	if (historyFrames >= neededFrames)
+		return;
+
+	const int32_t frames = neededFrames - historyFrames;
+
+	if (childDone)
+	{
+		for (int32_t c = 0; c < channels; c++)
+			memset(history + c * historyCapacity + historyFrames, 0, frames * sizeof(float));
+	}
+	else
+	{
+		// the child renders straight onto the end of the planes
+		for (int32_t c = 0; c < channels; c++)
+			memset(history + c * historyCapacity + historyFrames, 0, frames * sizeof(float));
+
+		const AudioBuffer input(history + historyFrames, frames, channels, historyCapacity);
+
+		Context childContext = GetContext();
+		childContext.hertz = childHertz;
+		childContext.maxBlockFrames = historyCapacity;
+		{
+			ContextScope scope(childContext);
+			child->Write(input);
+			child->TrackPeak(input);
+		}
+
+		if (child->done)
+		{
+			// the last real input frame, in window start terms
+			childDone = true;
+			tailFrames = historyFrames + frames - (taps / 2 - 1);
+		}
+	}
+
+	historyFrames = neededFrames;
+}
+
+static inline double ClampStep(double step)
+{
+	return step < kMinStep ? kMinStep : (step > kMaxStep ? kMaxStep : step);
+}
+
+// gains and rates step by curveStride per frame: 0 for the flat gain and
+// rate, 1 for automation curves, where pitch scales the rate
+bool Resampler::Process(const AudioBuffer & buffer, const float * gains, const float * rates, int32_t curveStride)
+{
+	const auto & context = GetContext();
+	const QualityTier & tier = kTiers[quality];
+	const int32_t numFrames = buffer.frames;
+	const int32_t step = buffer.GetStep();
+	const int32_t channelStride = buffer.GetChannelStride();
+
+	const double ratio = double(rate) * double(childHertz) / double(context.hertz);
+
+	// above full detail every tier takes the nearest phase
+	const bool interpolate = tier.interpolate && context.lod == 0;
+
+	// everything the windows of this pass will read, including the simd
+	// padding past the last tap
+	double lastPosition = readPosition;
+	if (curveStride == 0)
+		lastPosition += ClampStep(ratio * double(rates[0])) * (numFrames - 1);
+	else
+	{
+		for (int32_t frame = 0; frame < numFrames - 1; frame++)
+			lastPosition += ClampStep(ratio * double(rates[frame]));
+	}
+	Fill(int32_t(lastPosition) + taps + kSimdWidth);
+
+	for (int32_t frame = 0; frame < numFrames; frame++)
+	{
+		const int32_t index = int32_t(readPosition);
+		const float phase = float(readPosition - index) * float(phases);
+		const int32_t shift = index & (kSimdWidth - 1);
+		const int32_t base = index - shift;
+		const float frameGain = gains[frame * curveStride];
+
+		float * out = buffer.data + frame * step;
+
+		if (interpolate)
+		{
+			const int32_t p = int32_t(phase);
+			const float blend = phase - float(p);
+			const float * row0 = kernel + (p * kSimdWidth + shift) * kernelStride;
+			const float * row1 = row0 + kSimdWidth * kernelStride;
+
+			for (int32_t c = 0; c < channels; c++)
+			{
+				const float * plane = history + c * historyCapacity + base;
+				const float a = Dot(plane, row0, kernelStride);
+				const float b = Dot(plane, row1, kernelStride);
+				out[c * channelStride] += (a + (b - a) * blend) * frameGain;
+			}
+		}
+		else
+		{
+			const int32_t p = int32_t(phase + 0.5f);
+			const float * row = kernel + (p * kSimdWidth + shift) * kernelStride;
+
+			for (int32_t c = 0; c < channels; c++)
+				out[c * channelStride] += Dot(history + c * historyCapacity + base, row, kernelStride) * frameGain;
+		}
+
+		readPosition += ClampStep(ratio * double(rates[frame * curveStride]));
+	}
+
+	// drop consumed input in whole simd widths so the planes stay aligned
+	const int32_t consumed = int32_t(readPosition) & ~(kSimdWidth - 1);
+	if (consumed > 0)
+	{
+		for (int32_t c = 0; c < channels; c++)
+		{
+			float * plane = history + c * historyCapacity;
+			memmove(plane, plane + consumed, (historyFrames - consumed) * sizeof(float));
+		}
+
+		historyFrames -= consumed;
+		readPosition -= consumed;
+		tailFrames -= consumed;
+	}
+
+	return childDone && readPosition >= double(tailFrames);
+}
+
+bool Resampler::Write(const AudioBuffer & buffer)
+{
+	const auto & context = GetContext();
+	const int32_t numFrames = buffer.frames;
+	written = FrameRange();
+
+	if (!child || !kernel)
+	{
+		done = true;
+		return done;
+	}
+
+	// the filter rings on either side of what the child wrote, so the
+	// whole block is taken as written
+	written = FrameRange(0, numFrames);
+
+	int32_t passFrames = kPassFrames;
+	if (automation && automation->capacity < passFrames)
+		passFrames = automation->capacity;
+
+	const float flatRate = 1.0f;
+
+	bool finished = false;
+	for (int32_t start = 0; start < numFrames; start += passFrames)
+	{
+		int32_t frames = numFrames - start;
+		if (frames > passFrames)
+			frames = passFrames;
+
+		const AudioBuffer out = buffer.Slice(start, frames);
+		if (automation)
+		{
+			automation->Render(frames);
+			finished = Process(out, automation->gainCurve, automation->pitchCurve, 1);
+		}
+		else
+			finished = Process(out, &gain, &flatRate, 0);
+	}
+
+	if (automation)
+	{
+		gain = automation->gain.GetValue();
+		pitch = automation->pitch.GetValue();
+	}
+
+	time += float(numFrames) / float(context.hertz);
+	done = finished;
+	return done;
+}
+
+bool Resampler::Skip(int32_t numFrames)
+{
+	const auto & context = GetContext();
+
+	if (!child || !kernel)
+	{
+		done = true;
+		return done;
+	}
+
+	// where Write would leave the read position, rate curve and all
+	const double ratio = double(rate) * double(childHertz) / double(context.hertz);
+	double target = readPosition;
+	if (automation)
+	{
+		for (int32_t start = 0; start < numFrames; start += automation->capacity)
+		{
+			int32_t frames = numFrames - start;
+			if (frames > automation->capacity)
+				frames = automation->capacity;
+
+			automation->Render(frames);
+			for (int32_t frame = 0; frame < frames; frame++)
+				target += ClampStep(ratio * double(automation->pitchCurve[frame]));
+		}
+
+		gain = automation->gain.GetValue();
+		pitch = automation->pitch.GetValue();
+	}
+	else
+		target += ClampStep(ratio) * numFrames;
+
+	// drop in whole simd widths like Process, so the planes stay aligned;
+	// input past the history is skipped in the child rather than rendered
+	const int32_t consumed = int32_t(target) & ~(kSimdWidth - 1);
+	if (consumed <= historyFrames)
+	{
+		for (int32_t c = 0; c < channels; c++)
+		{
+			float * plane = history + c * historyCapacity;
+			memmove(plane, plane + consumed, (historyFrames - consumed) * sizeof(float));
+		}
+
+		historyFrames -= consumed;
+	}
+	else
+	{
+		if (!childDone)
+		{
+			Context childContext = context;
+			childContext.hertz = childHertz;
+			childContext.maxBlockFrames = historyCapacity;
+			ContextScope scope(childContext);
+
+			if (child->Skip(consumed - historyFrames))
+			{
+				// it ended somewhere in what was skipped, so no tail is owed
+				childDone = true;
+				tailFrames = consumed;
+			}
+		}
+
+		historyFrames = 0;
+	}
+
+	readPosition = target - consumed;
+	tailFrames -= consumed;
+
+	time += float(numFrames) / float(context.hertz);
+	done = childDone && readPosition >= double(tailFrames);
+	return done;
+}
+
+// the filter stays as Init designed it, for the rate in effect then
+bool Resampler::Rewind()
+{
+	Base::Rewind();
+	if (!child)
+	{
+		done = true;
+		return true;
+	}
+
+	if (history)
+		memset(history, 0, channels * historyCapacity * sizeof(float));
+	historyFrames = taps / 2 - 1;
+	readPosition = 0.0;
+	tailFrames = 0;
+
+	const bool rewound = child->Rewind();
+	childDone = child->done;
+	done = childDone;
+	return rewound;
+}
+
+// the child's latency is in its own frames, and plays back at rate
+int32_t Resampler::GetLatencyFrames() const
+{
+	if (!child)
+		return 0;
+
+	const double step = double(rate) * double(childHertz) / double(GetContext().hertz);
+	return int32_t(double(child->GetLatencyFrames()) / ClampStep(step));
+}
+
+Resampler::~Resampler()
+{
+	delete child;
+
+	BX_ALIGNED_FREE(&sAllocator, kernel, kSimdAlign);
+	AudioBuffer::Free(history);
+}
+
+}
@@ -0,0 +1,257 @@
+//
+//  sampler.cpp
+//  audiosample
+//
+
+#include "audio_writers.h"
+#include "audio_streamer.h"
+
+namespace AudioWriter
+{
+
+// frames pulled off the voice's ring per pass
+static const int32_t kReadFrames = 256;
+
+// spread or fold the file's interleaved channels over out's; gains steps
+// by gainStride per frame, 0 for a flat gain or 1 for an automation curve
+static void MixFrames(const AudioBuffer & out, const float * in, int32_t inChannels, const float * gains, int32_t gainStride)
+{
+	const int32_t step = out.GetStep();
+	for (int32_t c = 0; c < out.channels; c++)
+	{
+		float * channel = out.GetChannel(c);
+		const float * source = in + c % inChannels;
+		for (int32_t frame = 0; frame < out.frames; frame++)
+			channel[frame * step] += source[frame * inChannels] * gains[frame * gainStride];
+	}
+}
+
+Sampler::Sampler(const char * path, int64_t startFrame, int64_t loopStart, int64_t loopEnd)
+{
+	SampleStreamer * streamer = SampleStreamer::Instance();
+	if (streamer)
+		voice = streamer->CreateVoice(path, startFrame, loopStart, loopEnd);
+
+	if (voice)
+		scratchSpace = AudioBuffer::Allocate(kReadFrames, voice->file->GetInfo().channels);
+}
+
+Sampler::Sampler(const SampleView & view, int64_t startFrame, int64_t start, int64_t end) :
+	sample(view),
+	startPosition(startFrame > 0 ? startFrame : 0),
+	position(startPosition),
+	loopStart(start),
+	loopEnd(end)
+{
+}
+
+bool Sampler::Init()
+{
+	inited = true;
+	done = voice == nullptr && sample.IsFailed();
+
+	// a loop keeps whatever duration it was given; a one shot lasts as
+	// long as the rest of its file
+	if (voice)
+	{
+		const AudioWav::Info & info = voice->file->GetInfo();
+		looping = voice->loopEnd > voice->loopStart;
+		if (!looping)
+			duration = float(info.frames - voice->position) / float(info.hertz);
+	}
+	else
+		looping = loopStart >= 0 && loopEnd > loopStart;
+
+	return done;
+}
+
+bool Sampler::Write(const AudioBuffer & buffer)
+{
+	const auto & context = GetContext();
+	const int32_t numFrames = buffer.frames;
+	written = FrameRange();
+
+	if (automation)
+	{
+		// pitch is left alone; a sample plays at its own rate unless it
+		// sits under a Resampler
+		for (int32_t start = 0; start < numFrames; start += automation->capacity)
+		{
+			int32_t frames = numFrames - start;
+			if (frames > automation->capacity)
+				frames = automation->capacity;
+
+			automation->Render(frames);
+
+			const AudioBuffer out = buffer.Slice(start, frames);
+			int32_t filled = 0;
+			done = voice ? WriteStreamed(out, automation->gainCurve, 1, filled) : WriteResident(out, automation->gainCurve, 1, filled);
+			written.Include(FrameRange(0, filled), start);
+		}
+
+		gain = automation->gain.GetValue();
+	}
+	else
+	{
+		int32_t filled = 0;
+		done = voice ? WriteStreamed(buffer, &gain, 0, filled) : WriteResident(buffer, &gain, 0, filled);
+		written = FrameRange(0, filled);
+	}
+
+	time += float(numFrames) / float(context.hertz);
+	if (looping && duration > 0.0f && time >= duration)
+		done = true;
+
+	return done;
+}
+
+bool Sampler::WriteStreamed(const AudioBuffer & buffer, const float * gains, int32_t gainStride, int32_t & filled)
+{
+	const int32_t inChannels = voice->file->GetInfo().channels;
+	const int32_t numFrames = buffer.frames;
+
+	// read ended before the ring so the last frames queued are visible
+	const bool ended = voice->ended.load(std::memory_order_acquire);
+
+	int32_t cursor = 0;
+	while (cursor < numFrames)
+	{
+		int32_t frames = int32_t(voice->ring.GetAvailable() / inChannels);
+		if (frames == 0)
+			break;
+		if (frames > numFrames - cursor)
+			frames = numFrames - cursor;
+		if (frames > kReadFrames)
+			frames = kReadFrames;
+
+		voice->ring.Read(scratchSpace, uint32_t(frames * inChannels));
+		MixFrames(buffer.Slice(cursor, frames), scratchSpace, inChannels, gains + cursor * gainStride, gainStride);
+		cursor += frames;
+	}
+
+	// the rest of the block goes out silent; the voice picks up where it
+	// left off, late by however long the prefetch thread was behind
+	if (cursor < numFrames && !ended)
+		underruns++;
+
+	filled = cursor;
+	return ended && voice->ring.GetAvailable() == 0;
+}
+
+bool Sampler::WriteResident(const AudioBuffer & buffer, const float * gains, int32_t gainStride, int32_t & filled)
+{
+	// silence while the bank is still loading
+	filled = 0;
+	const float * samples = sample.GetSamples();
+	if (!samples)
+		return sample.IsFailed();
+
+	const AudioWav::Info & info = sample.GetInfo();
+	const int32_t numFrames = buffer.frames;
+
+	// loop points outside the sample, or backwards, just mean no loop
+	const bool wraps = loopStart >= 0 && loopEnd > loopStart && loopEnd <= info.frames;
+	const int64_t end = wraps ? loopEnd : info.frames;
+
+	int32_t cursor = 0;
+	while (cursor < numFrames)
+	{
+		if (position >= end)
+		{
+			if (!wraps)
+				break;
+			position = loopStart;
+		}
+
+		int64_t frames = end - position;
+		if (frames > numFrames - cursor)
+			frames = numFrames - cursor;
+
+		MixFrames(buffer.Slice(cursor, int32_t(frames)), samples + position * info.channels, info.channels, gains + cursor * gainStride, gainStride);
+
+		position += frames;
+		cursor += int32_t(frames);
+	}
+
+	filled = cursor;
+	return !wraps && position >= info.frames;
+}
+
+bool Sampler::Skip(int32_t numFrames)
+{
+	const auto & context = GetContext();
+
+	if (automation)
+	{
+		automation->Skip(numFrames);
+		gain = automation->gain.GetValue();
+	}
+
+	if (voice)
+	{
+		const int32_t inChannels = voice->file->GetInfo().channels;
+		const bool ended = voice->ended.load(std::memory_order_acquire);
+
+		const uint32_t wanted = uint32_t(numFrames * inChannels);
+		if (voice->ring.Skip(wanted) < wanted && !ended)
+			underruns++;
+
+		done = ended && voice->ring.GetAvailable() == 0;
+	}
+	else if (!sample.GetSamples())
+	{
+		// still loading, and Write wouldn't have moved either
+		done = sample.IsFailed();
+	}
+	else
+	{
+		const AudioWav::Info & info = sample.GetInfo();
+		const bool wraps = loopStart >= 0 && loopEnd > loopStart && loopEnd <= info.frames;
+		const int64_t end = wraps ? loopEnd : info.frames;
+
+		int64_t remaining = numFrames;
+		while (remaining > 0)
+		{
+			if (position >= end)
+			{
+				if (!wraps)
+					break;
+				position = loopStart;
+			}
+
+			const int64_t frames = end - position < remaining ? end - position : remaining;
+			position += frames;
+			remaining -= frames;
+		}
+
+		done = !wraps && position >= info.frames;
+	}
+
+	time += float(numFrames) / float(context.hertz);
+	if (looping && duration > 0.0f && time >= duration)
+		done = true;
+
+	return done;
+}
+
+bool Sampler::Rewind()
+{
+	Base::Rewind();
+	if (voice)
+		return false;
+
+	position = startPosition;
+	done = sample.IsFailed();
+	return true;
+}
+
+Sampler::~Sampler()
+{
+	SampleStreamer * streamer = SampleStreamer::Instance();
+	if (streamer && voice)
+		streamer->ReleaseVoice(voice);
+
+	AudioBuffer::Free(scratchSpace);
+}
+
+}
@@ -6,7 +6,9 @@
 //
 
 #include "audio_writers.h"
-#include "audio_module.h"
+#include "audio_mix.h"
+#include <stdlib.h>
+#include <string.h>
 
 namespace AudioWriter
 {
@@ -46,83 +48,170 @@ bool Sequencer::Init()
 			child->Init();
 		}
 		
-		// set up some scratch space for mixing children
-		scratchLen = 2 * 48000 * sizeof(float);
-		scratchSpace = (float*) malloc(scratchLen);
-		memset(scratchSpace, 0, scratchLen);
+		// set up some scratch space for mixing children, big enough for
+		// the largest block at whatever rate we're running
+		const auto & context = GetContext();
+		scratchFrames = context.maxBlockFrames;
+		scratchSpace = AudioBuffer::Allocate(scratchFrames, context.channels);
 	}
 	
 	done = children.size() == 0;
 	return done;
 }
 
-bool Sequencer::Write(float *buffer, int32_t numFrames)
+bool Sequencer::Write(const AudioBuffer & buffer)
 {
 	if (done)
 		return done;
 	
-	const auto & context = AudioSubmodule::Instance()->GetContext();
-	const float hertz = float(context.hertz);
-	const float timeJump = float (numFrames) / hertz;
+	const int32_t numFrames = buffer.frames;
 	
-	float childTime = time;
-	float endTime = time + timeJump;
-	while (childTime < endTime && timelineIndex < timeline.size())
+	// a block bigger than the scratch goes through in pieces
+	if (numFrames > scratchFrames)
 	{
-		childTime = timeline[timelineIndex];
-		if (childTime < time + timeJump)
+		FrameRange total;
+		for (int32_t start = 0; start < numFrames && !done; start += scratchFrames)
 		{
-			playQueue.push_back(children[timelineIndex]);
-			timeQueue.push_back(timeline[timelineIndex]);
-			timelineIndex++;
+			Write(buffer.Slice(start, numFrames - start < scratchFrames ? numFrames - start : scratchFrames));
+			total.Include(written, start);
 		}
+		
+		written = total;
+		return done;
 	}
 	
-	for (int32_t e = 0; e < playQueue.size(); e++)
+	const auto & context = GetContext();
+	const float hertz = float(context.hertz);
+	const float timeJump = float (numFrames) / hertz;
+	
+	QueueDue(time + timeJump);
+	written = FrameRange();
+	
+	// children render in the same layout they'll be mixed into
+	const AudioBuffer scratch = buffer.SameLayout(scratchSpace, numFrames, scratchFrames);
+	
+	for (int32_t e = queueIndex; e < timelineIndex; e++)
 	{
-		auto * child = playQueue[e];
+		auto * child = children[e];
 		if (child->done)
 			continue;
 		
-		float childTime = timeQueue[e];
+		float childTime = timeline[e];
 		int32_t childStart = 0;
 		if (childTime > time)
 		{
 			float delay = childTime - time;
 			childStart = delay * hertz;
 		}
-	
-		memset(scratchSpace, 0, scratchLen);
-		child->Write(scratchSpace + childStart, numFrames - childStart);
 		
-		// has known mis-performance where if there is zero padding
-		// off the end of it, it'll copy in the zeros, too, until it
-		// hits numFrames
-		for (int c = childStart; c < numFrames; c++)
+		if (child->SkipCulled(numFrames - childStart))
 		{
-			buffer[c] += scratchSpace[c];
+			child->Skip(numFrames - childStart);
+			continue;
 		}
-	}
 	
-	int32_t popcount = 0;
-	for (popcount = 0; popcount < playQueue.size(); popcount++)
-	{
-		auto * child = playQueue[popcount];
-		if (!child->done)
-			break;
+		// the scratch is kept zeroed between children; a child that
+		// starts late or ends early only costs the frames it wrote
+		const AudioBuffer childScratch = scratch.Slice(childStart, numFrames - childStart);
+		child->Write(childScratch);
+		child->TrackPeak(childScratch);
+		
+		const FrameRange & range = child->written;
+		if (range.IsSilent())
+			continue;
+		
+		const int32_t first = childStart + range.begin;
+		const AudioBuffer childOut = scratch.Slice(first, range.GetFrames());
+		child->FadeCull(childOut, range.begin);
+		AudioMix::Add(buffer.Slice(first, range.GetFrames()), childOut);
+		AudioMix::Zero(childOut);
+		written.Include(range, childStart);
 	}
 	
-	for ( ; popcount > 0; popcount-- )
+	PopDone();
+	
+	time += timeJump;
+	done = time > duration;
+	return done;
+}
+
+bool Sequencer::Skip(int32_t numFrames)
+{
+	if (done)
+		return done;
+	
+	const float hertz = float(GetContext().hertz);
+	const float timeJump = float (numFrames) / hertz;
+	
+	QueueDue(time + timeJump);
+	
+	for (int32_t e = queueIndex; e < timelineIndex; e++)
 	{
-		playQueue.pop_front();
-		timeQueue.pop_front();
+		auto * child = children[e];
+		if (child->done)
+			continue;
+		
+		float childTime = timeline[e];
+		int32_t childStart = 0;
+		if (childTime > time)
+			childStart = (childTime - time) * hertz;
+		
+		child->Skip(numFrames - childStart);
 	}
 	
+	PopDone();
+	
 	time += timeJump;
 	done = time > duration;
 	return done;
 }
 
+bool Sequencer::Rewind()
+{
+	Base::Rewind();
+	
+	timelineIndex = 0;
+	queueIndex = 0;
+	
+	bool rewound = true;
+	for (auto * child : children)
+		rewound &= child->Rewind();
+	
+	done = children.size() == 0;
+	return rewound;
+}
+
+// moves every child starting before endTime onto the play queue
+void Sequencer::QueueDue(float endTime)
+{
+	while (timelineIndex < timeline.size() && timeline[timelineIndex] < endTime)
+		timelineIndex++;
+}
+
+// drops finished children off the front of the play queue
+void Sequencer::PopDone()
+{
+	while (queueIndex < timelineIndex && children[queueIndex]->done)
+		queueIndex++;
+}
+
+float Sequencer::GetLevel() const
+{
+	float level = 0.0f;
+	for (int32_t e = queueIndex; e < timelineIndex; e++)
+	{
+		if (!children[e]->done)
+			level += children[e]->GetLevel();
+	}
+	
+	const auto & context = GetContext();
+	const float ahead = float(context.maxBlockFrames) / float(context.hertz);
+	if (timelineIndex < timeline.size() && timeline[timelineIndex] < time + ahead)
+		level += children[timelineIndex]->GetLevel();
+	
+	return level;
+}
+
 Sequencer::~Sequencer()
 {
 	for (auto * child : children)
@@ -130,10 +219,36 @@ Sequencer::~Sequencer()
 		delete child;
 	}
 	
-	free(scratchSpace);
+	AudioBuffer::Free(scratchSpace);
 	scratchSpace = nullptr;
 }
 
+bool Sequencer::CanRetire() const
+{
+	if (!Base::CanRetire() || timelineIndex < timeline.size())
+		return false;
+	
+	for (int32_t e = queueIndex; e < timelineIndex; e++)
+	{
+		if (!children[e]->done && !children[e]->CanRetire())
+			return false;
+	}
+	
+	return true;
+}
+
+int32_t Sequencer::GetLatencyFrames() const
+{
+	int32_t latency = 0;
+	for (auto * child : children)
+	{
+		const int32_t childLatency = child->GetLatencyFrames();
+		latency = childLatency > latency ? childLatency : latency;
+	}
+	
+	return latency;
+}
+
 void Sequencer::PushChild(Base * child, float cumulDelay)
 {
 	if (child && cumulDelay >= 0.0f)
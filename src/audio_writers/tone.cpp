@@ -6,8 +6,7 @@
 //
 
 #include "audio_writers.h"
-
-#include "audio_module.h"
+#include "audio_mix.h"
 #include <math.h>
 
 namespace AudioWriter
@@ -46,36 +45,157 @@ bool Tone::Init()
 {
 	inited = true;
 	done = wave == nullptr;
+	cycles = 0.0;
 	return done;
 }
 
-bool Tone::Write (float * buffer, int32_t numFrames)
+// a tone is mono; every channel after the first gets a copy of it
+static void CopyToChannels(const AudioBuffer & buffer, int32_t numFrames)
+{
+	const float * first = buffer.GetChannel(0);
+	const int32_t step = buffer.GetStep();
+	for (int32_t channel = 1; channel < buffer.channels; channel++)
+	{
+		float * out = buffer.GetChannel(channel);
+		for (int32_t frame = 0; frame < numFrames; frame++)
+			out[frame * step] = first[frame * step];
+	}
+}
+
+bool Tone::Write (const AudioBuffer & buffer)
 {
-	const auto & context = AudioSubmodule::Instance()->GetContext();
+	const auto & context = GetContext();
 	const float hertz = float(context.hertz);
-	const float timeStep = 1.0f / float(hertz);
+	const int32_t numFrames = buffer.frames;
 
 	int32_t cursor = 0;
+	written = FrameRange();
 
 	if (time < duration)
 	{
+		// round the last partial frame up, or a remainder under one frame
+		// would never get written and the tone would never finish
 		float writeTime = duration - time;
-		int32_t writeFrames = int32_t(writeTime * hertz);
+		int32_t writeFrames = int32_t(ceilf(writeTime * hertz));
 
 		if (writeFrames > numFrames)
 			writeFrames = numFrames;
 
-		for( int32_t writeCursor = 0; writeCursor < writeFrames && cursor < numFrames; writeCursor++, time += timeStep )
+		const double startTime = time;
+
+		if (automation)
+		{
+			WriteAutomated(buffer.Slice(0, writeFrames));
+		}
+		else
 		{
-			float value = wave(time, pitch, phase/hertz);
-			value *= gain;
-			buffer[cursor++] = value;
+			float * out = buffer.GetChannel(0);
+			const int32_t step = buffer.GetStep();
+
+			// time each frame from the start of the block rather than adding a
+			// step per frame; at 96k and up the float error from stepping adds
+			// up to audible drift within a few seconds
+			for( int32_t writeCursor = 0; writeCursor < writeFrames && cursor < numFrames; writeCursor++ )
+			{
+				const float frameTime = float(startTime + double(writeCursor) / double(hertz));
+				float value = wave(frameTime, pitch, phase/hertz);
+				value *= gain;
+				out[(cursor++) * step] = value;
+			}
 		}
+
+		CopyToChannels(buffer, writeFrames);
+
+		time = float(startTime + double(writeFrames) / double(hertz));
+		written = FrameRange(0, writeFrames);
 	}
 
 	done = time >= duration;
 	return done;
 }
 
+bool Tone::Skip(int32_t numFrames)
+{
+	const double hertz = double(GetContext().hertz);
+
+	if (time < duration)
+	{
+		int32_t skipFrames = int32_t(ceilf((duration - time) * float(hertz)));
+		if (skipFrames > numFrames)
+			skipFrames = numFrames;
+
+		// the cycle count follows the pitch curve, so it has to be summed
+		if (automation)
+		{
+			for (int32_t start = 0; start < skipFrames; start += automation->capacity)
+			{
+				int32_t frames = skipFrames - start;
+				if (frames > automation->capacity)
+					frames = automation->capacity;
+
+				automation->Render(frames);
+				for (int32_t frame = 0; frame < frames; frame++)
+					cycles += double(automation->pitchCurve[frame]) / hertz;
+				cycles -= floor(cycles);
+			}
+
+			gain = automation->gain.GetValue();
+			pitch = automation->pitch.GetValue();
+		}
+
+		time = float(double(time) + double(skipFrames) / hertz);
+	}
+
+	done = time >= duration;
+	return done;
+}
+
+bool Tone::Rewind()
+{
+	Base::Rewind();
+	done = wave == nullptr;
+	cycles = 0.0;
+	return true;
+}
+
+// with pitch moving inside the block, time * pitch no longer says where
+// in the cycle we are, so count cycles instead and hand the wave that
+// position at a pitch of one
+void Tone::WriteAutomated(const AudioBuffer & buffer)
+{
+	const double hertz = double(GetContext().hertz);
+	const float phaseOffset = phase / float(hertz);
+	const int32_t numFrames = buffer.frames;
+	const int32_t step = buffer.GetStep();
+
+	for (int32_t start = 0; start < numFrames; start += automation->capacity)
+	{
+		int32_t frames = numFrames - start;
+		if (frames > automation->capacity)
+			frames = automation->capacity;
+
+		automation->Render(frames);
+
+		float * out = buffer.GetChannel(0) + start * step;
+		for (int32_t frame = 0; frame < frames; frame++)
+		{
+			out[frame * step] = wave(float(cycles), 1.0f, phaseOffset);
+
+			cycles += double(automation->pitchCurve[frame]) / hertz;
+			cycles -= floor(cycles);
+		}
+
+		if (step == 1)
+			AudioMix::Multiply(out, automation->gainCurve, frames);
+		else
+		{
+			for (int32_t frame = 0; frame < frames; frame++)
+				out[frame * step] *= automation->gainCurve[frame];
+		}
+	}
+
+	gain = automation->gain.GetValue();
+	pitch = automation->pitch.GetValue();
+}
 
 }
@@ -4,6 +4,12 @@
  * entrypoint for graphical applications.
  */
 #include "entry_point.h"
+#include <bx/commandline.h>
+
+static void PostAudioError(const char * error)
+{
+	DebugSubmodule::Instance()->SetDebugString(error);
+}
 
 AppWrapper::AppWrapper(const char* _name, const char* _description, const char* _url)
 	: entry::AppI(_name, _description, _url)
@@ -13,21 +19,71 @@ AppWrapper::AppWrapper(const char* _name, const char* _description, const char*
 void AppWrapper::init(int32_t _argc, const char* const* _argv, uint32_t _width, uint32_t _height) 
 {
 	Args args(_argc, _argv);
+	bx::CommandLine cmdLine(_argc, _argv);
+
+	// --job-threads <n> sets how many workers the shared pool runs besides
+	// the main thread; the rest of the app finds it through Instance
+	JobPool::Config jobsConfig;
+	cmdLine.hasArg(jobsConfig.threads, '\0', "job-threads");
+	m_jobs.Init(jobsConfig);
 
 	m_graphics.Init(args.m_type, args.m_pciId, _width, _height, BGFX_RESET_VSYNC);
 	m_debug.Init(BGFX_DEBUG_TEXT);
 	m_ui.Init(_width, _height);
 	
-	m_audio.Init();
+	// --audio-dsp renders inside FMOD's mixer instead of through a user
+	// stream, for comparing trigger latency between the two; --audio-null
+	// runs without a device at all; --audio-hertz <rate> overrides the
+	// device's rate; --audio-capture <path> records the mix to a wav file
+	// for the whole session; --audio-parallel renders streams side by side
+	// on the job pool; --audio-priority <n> runs the mixer and job workers
+	// at realtime priority n, --audio-cores <mask> pins them to cores,
+	// --audio-lock-memory locks the process in memory and --audio-prefault
+	// touches audio stacks and buffers up front; --audio-voices <n> sets how
+	// many streams render for real before the quietest go virtual;
+	// --audio-sub-block <frames> renders each stream's tree that many
+	// frames at a time; --audio-channels <n> mixes to n output channels
+	AudioSubmodule::Config audioConfig;
+	audioConfig.onError = PostAudioError;
+#if AUDIO_CONFIG_FMOD
+	if (cmdLine.hasArg("audio-dsp"))
+		audioConfig.backend = AudioBackend::kFMODDSP;
+#endif
+	if (cmdLine.hasArg("audio-null"))
+		audioConfig.backend = AudioBackend::kNullRealtime;
+	cmdLine.hasArg(audioConfig.hertz, '\0', "audio-hertz");
+	cmdLine.hasArg(audioConfig.channels, '\0', "audio-channels");
+	audioConfig.parallelStreams = cmdLine.hasArg("audio-parallel");
+	cmdLine.hasArg(audioConfig.realtime.priority, '\0', "audio-priority");
+	uint32_t audioCores = 0;
+	if (cmdLine.hasArg(audioCores, '\0', "audio-cores"))
+		audioConfig.realtime.cores = audioCores;
+	audioConfig.realtime.lockMemory = cmdLine.hasArg("audio-lock-memory");
+	audioConfig.realtime.prefault = cmdLine.hasArg("audio-prefault");
+	cmdLine.hasArg(audioConfig.realVoices, '\0', "audio-voices");
+	cmdLine.hasArg(audioConfig.subBlockFrames, '\0', "audio-sub-block");
+	
+	m_audio.Init(audioConfig);
+	
+	const char * capturePath = nullptr;
+	if (cmdLine.hasArg(capturePath, '\0', "audio-capture"))
+		m_audio.StartCapture(capturePath);
+	
 	StartLogic();
 }
 
+void AppWrapper::LogicJob(void * userData)
+{
+	((AppWrapper *) userData)->UpdateLogic(1.0f/60.0f);
+}
+
 int AppWrapper::shutdown()
 {
 	m_audio.Shutdown();
 	m_ui.Shutdown();
 	m_debug.Shutdown();
 	m_graphics.Shutdown();
+	m_jobs.Shutdown();
 
 	return 0;
 }
@@ -44,10 +100,16 @@ bool AppWrapper::update()
 	
 	if (!stop)
 	{
-		UpdateLogic(1.0f/60.0f);
+		// the frame's logic runs on the pool as background work while
+		// this thread presents, so audio blocks have real work to go
+		// ahead of; with no workers it just runs here first
+		JobCounter logic;
+		m_jobs.Submit(LogicJob, this, JobPool::kBackground, &logic);
 	
 		m_ui.Update();
 		m_graphics.Update();
+	
+		m_jobs.Wait(logic);
 		m_audio.Update();
 		return true;
 	}
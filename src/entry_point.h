@@ -11,9 +11,12 @@
 
 #include "presentation_modules.h"
 #include "audio_module.h"
+#include "job_pool.h"
 
 class AppWrapper : public entry::AppI
 {
+	// shared by every submodule; declared first so it outlives them
+	JobPool m_jobs;
 	GraphicsSubmodule m_graphics;
 	UiSubmodule m_ui;
 	DebugSubmodule m_debug;
@@ -21,6 +24,10 @@ class AppWrapper : public entry::AppI
 	
 	void StartLogic();
 	void UpdateLogic(float dt);
+	
+	// UpdateLogic as a pool job; it only touches the logic's own state
+	// and the audio command queue, so it can overlap presentation
+	static void LogicJob(void * userData);
 
 public:
 
@@ -0,0 +1,262 @@
+//
+//  job_pool.cpp
+//  audiosample
+//
+
+#include "job_pool.h"
+
+#include <bx/os.h>
+#include <thread>
+
+JobPool * JobPool::sInstance;
+
+JobPool::JobPool()
+{
+	BX_ASSERT(sInstance == nullptr);
+	sInstance = this;
+}
+
+JobPool::~JobPool()
+{
+	Shutdown();
+	sInstance = nullptr;
+}
+
+int32_t JobPool::ThreadFunc(bx::Thread * self, void * userData)
+{
+	Worker * worker = (Worker *) userData;
+	worker->pool->Run(worker->index);
+	return 0;
+}
+
+void JobPool::Run(int32_t worker)
+{
+	for (;;)
+	{
+		work.wait();
+		if (!running.load(std::memory_order_acquire))
+			break;
+
+		if (workers[worker].setupApplied != setupGeneration.load(std::memory_order_acquire))
+			ApplySetup(worker);
+
+		// a block being rendered comes before anything queued
+		if (TakeSeat())
+		{
+			RunTasks(worker);
+			active.fetch_sub(1, std::memory_order_release);
+			continue;
+		}
+
+		Job job;
+		if (PopJob(job))
+			RunJob(job);
+	}
+}
+
+// runs once per SetupWorkers call, so the lock is only ever contended
+// right after one
+void JobPool::ApplySetup(int32_t worker)
+{
+	bx::MutexScope scope(setupLock);
+
+	workers[worker].setupApplied = setupGeneration.load(std::memory_order_relaxed);
+	if (setupFn)
+		setupFn(setupData, worker);
+}
+
+// claims one of the seats the ParallelFor in flight left for workers
+bool JobPool::TakeSeat()
+{
+	int32_t open = seats.load(std::memory_order_acquire);
+	while (open > 0 && !seats.compare_exchange_weak(open, open - 1, std::memory_order_acquire))
+	{
+	}
+
+	return open > 0;
+}
+
+// own run first, then whatever is left of everyone else's
+void JobPool::RunTasks(int32_t worker)
+{
+	for (int32_t offset = 0; offset < numWorkers; offset++)
+	{
+		Range & range = ranges[(worker + offset) % numWorkers];
+
+		for (;;)
+		{
+			const int32_t task = range.next.fetch_add(1, std::memory_order_relaxed);
+			if (task >= range.end)
+				break;
+
+			taskFn(taskData, task, worker);
+			completed.fetch_add(1, std::memory_order_release);
+		}
+	}
+}
+
+bool JobPool::PopJob(Job & job)
+{
+	bx::MutexScope scope(queueLock);
+
+	for (auto & queue : queues)
+	{
+		if (!queue.empty())
+		{
+			job = queue.front();
+			queue.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobPool::RunJob(const Job & job)
+{
+	job.fn(job.userData);
+	if (job.counter)
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+bool JobPool::Init()
+{
+	return Init(Config());
+}
+
+bool JobPool::Init(const Config & config)
+{
+	int32_t threads = config.threads;
+	if (threads < 0)
+		threads = int32_t(std::thread::hardware_concurrency()) - 1;
+	if (threads > kMaxWorkers - 1)
+		threads = kMaxWorkers - 1;
+
+	numWorkers = 1;
+	running.store(true, std::memory_order_release);
+
+	for (int32_t w = 1; w <= threads; w++)
+	{
+		Worker & worker = workers[w];
+		worker.pool = this;
+		worker.index = w;
+
+		if (!worker.thread.init(ThreadFunc, &worker, 0, "job worker"))
+			return false;
+
+		numWorkers++;
+	}
+
+	return true;
+}
+
+void JobPool::Shutdown()
+{
+	if (!running.exchange(false))
+		return;
+
+	work.post(uint32_t(numWorkers - 1));
+	for (int32_t w = 1; w < numWorkers; w++)
+		workers[w].thread.shutdown();
+
+	numWorkers = 1;
+
+	// anyone waiting on a counter still gets their jobs run
+	Job job;
+	while (PopJob(job))
+		RunJob(job);
+}
+
+void JobPool::ParallelFor(TaskFn fn, void * userData, int32_t numTasks)
+{
+	if (numTasks <= 0)
+		return;
+
+	bool idle = false;
+	if (numWorkers == 1 || numTasks == 1 || !busy.compare_exchange_strong(idle, true, std::memory_order_acquire))
+	{
+		for (int32_t task = 0; task < numTasks; task++)
+			fn(userData, task, 0);
+		return;
+	}
+
+	// no point waking more workers than there are tasks
+	const int32_t used = numTasks < numWorkers ? numTasks : numWorkers;
+
+	taskFn = fn;
+	taskData = userData;
+	completed.store(0, std::memory_order_relaxed);
+
+	// runs the caller could not take are left empty, so stealing skips them
+	for (int32_t w = 0; w < numWorkers; w++)
+	{
+		const int32_t begin = w < used ? int32_t(int64_t(numTasks) * w / used) : numTasks;
+		const int32_t end = w < used ? int32_t(int64_t(numTasks) * (w + 1) / used) : numTasks;
+		ranges[w].end = end;
+		ranges[w].next.store(begin, std::memory_order_relaxed);
+	}
+
+	active.store(used - 1, std::memory_order_relaxed);
+	seats.store(used - 1, std::memory_order_release);
+	work.post(uint32_t(used - 1));
+
+	RunTasks(0);
+
+	// workers that never got here, busy with a job, are let off; the
+	// ones that joined have to check back in, or a late one could pick up
+	// the next dispatch's ranges with this dispatch's task
+	const int32_t unclaimed = seats.exchange(0, std::memory_order_acq_rel);
+	active.fetch_sub(unclaimed, std::memory_order_acq_rel);
+
+	while (completed.load(std::memory_order_acquire) < numTasks || active.load(std::memory_order_acquire) > 0)
+		bx::yield();
+
+	busy.store(false, std::memory_order_release);
+}
+
+void JobPool::Submit(JobFn fn, void * userData, Priority priority, JobCounter * counter)
+{
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	Job job = { fn, userData, counter };
+	if (numWorkers == 1 || !running.load(std::memory_order_acquire))
+	{
+		RunJob(job);
+		return;
+	}
+
+	{
+		bx::MutexScope scope(queueLock);
+		queues[priority].push_back(job);
+	}
+
+	work.post();
+}
+
+void JobPool::Wait(JobCounter & counter)
+{
+	while (!counter.IsDone())
+	{
+		Job job;
+		if (PopJob(job))
+			RunJob(job);
+		else
+			bx::yield();
+	}
+}
+
+void JobPool::SetupWorkers(SetupFn fn, void * userData)
+{
+	if (numWorkers == 1)
+		return;
+
+	{
+		bx::MutexScope scope(setupLock);
+		setupFn = fn;
+		setupData = userData;
+		setupGeneration.fetch_add(1, std::memory_order_release);
+	}
+
+	work.post(uint32_t(numWorkers - 1));
+}
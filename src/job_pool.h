@@ -0,0 +1,171 @@
+//
+//  job_pool.h
+//  audiosample
+//
+
+#ifndef job_pool_h
+#define job_pool_h
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <bx/mutex.h>
+#include <bx/thread.h>
+#include <bx/semaphore.h>
+
+// Counts jobs still to run; Submit bumps it, the job finishing drops it.
+struct JobCounter
+{
+	std::atomic<int32_t> pending { 0 };
+
+	bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// The one pool of worker threads the app has, shared by the audio engine
+// and the frame loop so the two never fight over cores.
+//
+// Work comes in two forms.  ParallelFor splits one block's work across
+// every worker and waits for it: each worker starts on a contiguous run
+// of tasks and steals from the front of the others' once its own is
+// empty, and the calling thread works too, as worker 0.  Submit queues
+// a single job to run later at a priority.
+//
+// Priorities are strict.  A waking worker joins a ParallelFor in flight
+// before it looks at the queues, then takes realtime jobs before
+// background ones, so audio blocks get in ahead of queued decoding or
+// baking.  A job already running is never interrupted, which is why
+// background jobs should be small.  ParallelFor only counts on workers
+// that actually joined it, so workers stuck in long jobs can delay a
+// block but can't stall it.
+//
+// Only one ParallelFor runs at a time.  A call made while another is in
+// flight, including one from inside a task, runs its tasks serially on
+// the calling thread, so nesting never deadlocks.
+class JobPool
+{
+public:
+	using TaskFn = void (*)(void * userData, int32_t task, int32_t worker);
+	using JobFn = void (*)(void * userData);
+	using SetupFn = void (*)(void * userData, int32_t worker);
+
+	static const int32_t kMaxWorkers = 16;
+
+	enum Priority
+	{
+		kRealtime,
+		kBackground,
+
+		kNumPriorities
+	};
+
+	struct Config
+	{
+		// worker threads besides the caller; negative picks one less than
+		// the number of cores
+		int32_t threads = -1;
+	};
+
+private:
+	struct Worker
+	{
+		bx::Thread thread;
+		JobPool * pool = nullptr;
+		int32_t index = 0;
+		uint32_t setupApplied = 0;
+	};
+
+	// the run of tasks a worker starts on; owner and thieves both claim
+	// from next, padded so workers don't share a cache line
+	struct Range
+	{
+		std::atomic<int32_t> next { 0 };
+		int32_t end = 0;
+		uint8_t pad[56];
+	};
+
+	struct Job
+	{
+		JobFn fn;
+		void * userData;
+		JobCounter * counter;
+	};
+
+	Worker workers[kMaxWorkers];
+	Range ranges[kMaxWorkers];
+	int32_t numWorkers = 1;
+
+	// one post per queued job or ParallelFor seat; any worker can take it
+	bx::Semaphore work;
+
+	std::atomic<bool> running { false };
+	std::atomic<bool> busy { false };
+
+	// the dispatch in flight
+	TaskFn taskFn = nullptr;
+	void * taskData = nullptr;
+	std::atomic<int32_t> completed { 0 };
+	std::atomic<int32_t> seats { 0 };
+	std::atomic<int32_t> active { 0 };
+
+	// per thread setup every worker applies before it next runs anything;
+	// fn and data only change together under setupLock, and a worker
+	// holds it while it reads and runs them, so it never pairs one
+	// generation's fn with another's data
+	SetupFn setupFn = nullptr;
+	void * setupData = nullptr;
+	std::atomic<uint32_t> setupGeneration { 0 };
+	bx::Mutex setupLock;
+
+	// guards the queues; never taken by ParallelFor
+	bx::Mutex queueLock;
+	std::deque<Job> queues[kNumPriorities];
+
+	static JobPool * sInstance;
+
+	static int32_t ThreadFunc(bx::Thread * self, void * userData);
+	void Run(int32_t worker);
+	void ApplySetup(int32_t worker);
+	void RunTasks(int32_t worker);
+	bool TakeSeat();
+	bool PopJob(Job & job);
+	void RunJob(const Job & job);
+
+public:
+	JobPool();
+	~JobPool();
+
+	static JobPool * Instance() { return sInstance; }
+
+	bool Init();
+	bool Init(const Config & config);
+
+	// finishes whatever is still queued on the calling thread
+	void Shutdown();
+
+	// workers including the caller, so at least one; per worker buffers
+	// are indexed by the worker argument tasks get
+	int32_t GetNumWorkers() const { return numWorkers; }
+
+	// runs fn for every task in [0, numTasks) and waits for them all;
+	// never locks, so it's fine on the audio thread
+	void ParallelFor(TaskFn fn, void * userData, int32_t numTasks);
+
+	// queues fn to run on a worker; takes a lock, so not from the audio
+	// thread.  With no workers it runs right away on the caller.
+	void Submit(JobFn fn, void * userData, Priority priority = kBackground, JobCounter * counter = nullptr);
+
+	// runs queued jobs on the calling thread until counter is done
+	void Wait(JobCounter & counter);
+
+	// has every worker thread run fn once, for things like scheduling
+	// that can only be set from the thread itself.  Doesn't wait: an idle
+	// worker is woken to apply it, a busy one applies it when its current
+	// job ends, and either way it's in place before the worker's next
+	// task.  The caller, worker 0, is left to set itself up.  Passing
+	// null withdraws fn before whatever userData points at goes away; it
+	// waits for any worker still running the old fn, so once it returns
+	// nothing will call it again.
+	void SetupWorkers(SetupFn fn, void * userData);
+};
+
+#endif /* job_pool_h */
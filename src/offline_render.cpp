@@ -0,0 +1,585 @@
+//
+//  offline_render.cpp
+//  audiosample
+//
+
+// Headless renderer: builds a score from the test generators and renders
+// it to a wav file as fast as the cpu allows.  Links only the writers,
+// the mixing helpers and the wav writer; no window, bgfx or FMOD.
+
+#include <bx/commandline.h>
+#include <bx/timer.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "audio_bank.h"
+#include "audio_mix.h"
+#include "audio_scores.h"
+#include "audio_streamer.h"
+#include "audio_wav.h"
+#include "audio_writers.h"
+#include "job_pool.h"
+
+// same default as AudioStream::volume, so renders match the app
+static const float kVoiceVolume = 0.701f;
+
+// the writers size their scratch from the block, so keep it sane
+static const int32_t kMaxBlockFrames = 16384;
+
+// rates the benchmark sweeps; cost is reported relative to 48k
+static const int32_t kBenchRates[] = { 44100, 48000, 96000, 192000 };
+static const int32_t kBenchReferenceRate = 48000;
+
+// callback sizes the block benchmark sweeps, up to what FMOD can ask for
+static const int32_t kBenchBlocks[] = { 64, 256, 1024, 4096, 16384 };
+
+// sub-block the block benchmark compares against when none is given
+static const int32_t kBenchSubBlockFrames = 256;
+
+// each block benchmark case keeps its best of this many runs, alternating
+// whole and sub-block runs so neither gets a warmer machine
+static const int32_t kBenchRepeats = 3;
+
+// how long a writer has to stay under --retire before it's retired
+static const float kRetireSeconds = 0.05f;
+
+// sample files at most this big are mapped; the sample score's stereo
+// file is bigger at any rate, so it streams through the file reader
+static const uint64_t kSampleMapLimit = 1ull << 20;
+
+// decoded bytes the sample bank keeps; at 48k the bank score's hits take
+// 192KB each, so this holds the two that play but not the preloaded ones
+static const uint64_t kSampleBankBudget = 512ull << 10;
+
+struct ScoreEntry
+{
+	const char * name;
+	AudioWriter::Base * (*create)();
+};
+
+static const ScoreEntry kScores[] =
+{
+	{ "melody", MelodyTest },
+	{ "harmony", HarmonyTest },
+	{ "chord", ChordTest },
+	{ "scale", ScaleTest },
+	{ "sequence", SequenceTest },
+	{ "simple", SimpleTest },
+	{ "dense", DenseTest },
+	{ "pipeline", PipelineTest },
+	{ "instrument", InstrumentTest },
+	{ "lead", LeadTest },
+	{ "pluck", PluckTest },
+	{ "sample", SampleTest },
+	{ "bank", BankTest },
+};
+
+static const int32_t kNumScores = sizeof(kScores) / sizeof(kScores[0]);
+
+struct RenderStats
+{
+	uint64_t frames = 0;
+	double seconds = 0.0;
+
+	// cpu seconds spent in each tree, and busy seconds of each worker
+	std::vector<double> treeSeconds;
+	std::vector<double> workerSeconds;
+
+	double AudioSeconds(int32_t hertz) const { return double(frames) / double(hertz); }
+	double RealTimeFactor(int32_t hertz) const { return seconds > 0.0 ? AudioSeconds(hertz) / seconds : 0.0; }
+};
+
+static void PrintUsage()
+{
+	printf(
+		"audiorender - renders test scores to a wav file, faster than real time\n"
+		"\n"
+		"  -s, --score <names>       comma separated scores to mix (default melody,harmony)\n"
+		"  -o, --output <path>       wav file to write (default render.wav)\n"
+		"  -r, --hertz <rate>        sample rate (default 48000)\n"
+		"  -b, --block <frames>      frames per block (default 512)\n"
+		"  -c, --channels <n>        output channels, the scores panned across the front (default 1)\n"
+		"  -t, --max-seconds <secs>  stop after this much audio (default 600)\n"
+		"  -j, --threads <n>         worker threads for parallel writers (default one per extra core)\n"
+		"  -l, --lod <n>             render at a fixed level of detail, 0 (full) to 3\n"
+		"      --retire <dBFS>       retire writers quieter than this for 50ms (default off)\n"
+		"      --sub-block <frames>  render each block through the trees this many frames at a time (default off)\n"
+		"      --parallel-streams    render each score on the worker pool, and report the load\n"
+		"      --no-output           render without writing, for timing only\n"
+		"      --bench               time the scores at 44.1, 48, 96 and 192 kHz\n"
+		"      --bench-blocks        time the scores at block sizes from 64 to 16384, whole and in sub-blocks\n"
+		"  -h, --help                this text\n"
+		"\n"
+		"scores:"
+		);
+
+	for (int32_t c = 0; c < kNumScores; c++)
+		printf(" %s", kScores[c].name);
+	printf("\n");
+}
+
+static const ScoreEntry * FindScore(const char * name, size_t length)
+{
+	for (int32_t c = 0; c < kNumScores; c++)
+	{
+		if (strlen(kScores[c].name) == length && 0 == strncmp(name, kScores[c].name, length))
+			return &kScores[c];
+	}
+	return nullptr;
+}
+
+// builds one tree per comma separated name; returns false on a bad name
+static bool BuildScores(const char * list, std::vector<AudioWriter::Base*> & trees)
+{
+	const char * name = list;
+	while (*name)
+	{
+		const char * comma = strchr(name, ',');
+		const size_t length = comma ? size_t(comma - name) : strlen(name);
+
+		const ScoreEntry * score = FindScore(name, length);
+		if (!score)
+		{
+			fprintf(stderr, "unknown score '%.*s'\n", int(length), name);
+			return false;
+		}
+
+		trees.push_back(score->create());
+
+		if (!comma)
+			break;
+		name = comma + 1;
+	}
+
+	return !trees.empty();
+}
+
+// one block's worth of trees to render, each into its own buffer so they
+// can go to the job pool and still be summed in a fixed order
+struct RenderJob
+{
+	std::vector<AudioWriter::Base*> * trees = nullptr;
+	std::vector<float*> outputs;
+	std::vector<AudioWriter::FrameRange> written;
+	std::vector<uint8_t> rendered;
+	int32_t blockFrames = 0;
+
+	// cpu ticks per tree and per worker, over the whole render
+	std::vector<int64_t> treeTicks;
+	int64_t workerTicks[JobPool::kMaxWorkers] = {};
+};
+
+static void RenderTree(void * userData, int32_t task, int32_t worker)
+{
+	RenderJob * job = (RenderJob *) userData;
+	const int64_t begin = bx::getHPCounter();
+
+	AudioWriter::Base * root = (*job->trees)[task];
+	const AudioBuffer output(job->outputs[task], job->blockFrames, AudioWriter::GetContext().channels);
+
+	// outputs stay zeroed between blocks; the mix clears what it sums
+	job->rendered[task] = root && !root->done;
+	if (job->rendered[task])
+	{
+		const auto & context = AudioWriter::GetContext();
+		const int32_t step = context.subBlockFrames > 0 && context.subBlockFrames < job->blockFrames ? context.subBlockFrames : job->blockFrames;
+
+		AudioWriter::FrameRange & written = job->written[task];
+		written = AudioWriter::FrameRange();
+		for (int32_t start = 0; start < job->blockFrames && !root->done; start += step)
+		{
+			const int32_t frames = job->blockFrames - start < step ? job->blockFrames - start : step;
+			const AudioBuffer out = output.Slice(start, frames);
+			root->Write(out);
+			root->TrackPeak(out);
+			written.Include(root->written, start);
+		}
+	}
+
+	const int64_t ticks = bx::getHPCounter() - begin;
+	job->treeTicks[task] += ticks;
+	job->workerTicks[worker] += ticks;
+}
+
+// renders every tree block by block until they are all done or the
+// frame limit is hit, mixing the same way the AudioSubmodule bus does;
+// with a pool the trees of each block render in parallel, and the mix
+// comes out the same either way
+static RenderStats RenderTrees(std::vector<AudioWriter::Base*> & trees, int32_t blockFrames, uint64_t maxFrames, WavWriter * wav, JobPool * pool = nullptr, int32_t outputChannels = 1)
+{
+	const auto & context = AudioWriter::GetContext();
+	const int32_t numTrees = int32_t(trees.size());
+
+	// mono mixes straight into the block; more channels mix into a planar
+	// bus that's interleaved into the block in one pass
+	const AudioBuffer block(AudioBuffer::Allocate(blockFrames, outputChannels), blockFrames, outputChannels);
+	const AudioBuffer bus = outputChannels > 1 ? AudioBuffer(AudioBuffer::Allocate(blockFrames, outputChannels), blockFrames, outputChannels, AudioBuffer::GetPlaneStride(blockFrames)) : block;
+
+	// the scores spread evenly from half left to half right
+	std::vector<float> gains(size_t(numTrees) * AudioMix::kMaxChannels);
+	for (int32_t c = 0; c < numTrees; c++)
+	{
+		float * treeGains = &gains[size_t(c) * AudioMix::kMaxChannels];
+		AudioMix::PanGains(numTrees > 1 ? float(c) / float(numTrees - 1) - 0.5f : 0.0f, outputChannels, treeGains);
+		for (int32_t channel = 0; channel < outputChannels; channel++)
+			treeGains[channel] *= kVoiceVolume;
+	}
+
+	RenderJob job;
+	job.trees = &trees;
+	for (int32_t c = 0; c < numTrees; c++)
+		job.outputs.push_back(AudioBuffer::Allocate(blockFrames, context.channels));
+	job.written.assign(numTrees, AudioWriter::FrameRange());
+	job.rendered.assign(numTrees, 0);
+	job.treeTicks.assign(numTrees, 0);
+	job.blockFrames = blockFrames;
+
+	RenderStats stats;
+	const int64_t startTick = bx::getHPCounter();
+
+	for (auto * root : trees)
+	{
+		if (root && !root->inited)
+			root->Init();
+	}
+
+	SampleStreamer * streamer = SampleStreamer::Instance();
+	SampleBank * bank = SampleBank::Instance();
+
+	bool playing = true;
+	while (playing && stats.frames < maxFrames)
+	{
+		// there's no deadline to miss, so rather than race a prefetch
+		// thread the streamed voices are topped up before every block
+		if (streamer)
+			streamer->Pump();
+
+		if (pool)
+			pool->ParallelFor(RenderTree, &job, numTrees);
+		else
+		{
+			for (int32_t c = 0; c < numTrees; c++)
+				RenderTree(&job, c, 0);
+		}
+
+		AudioMix::Zero(block);
+
+		playing = false;
+		for (int32_t c = 0; c < numTrees; c++)
+		{
+			if (!job.rendered[c])
+				continue;
+
+			playing |= !trees[c]->done;
+
+			const AudioWriter::FrameRange & range = job.written[c];
+			if (range.IsSilent())
+				continue;
+
+			const AudioBuffer output = AudioBuffer(job.outputs[c], blockFrames, context.channels).Slice(range.begin, range.GetFrames());
+			AudioMix::AddPanned(bus.Slice(range.begin, output.frames), output, &gains[size_t(c) * AudioMix::kMaxChannels]);
+			AudioMix::Zero(output);
+		}
+
+		if (bus.data != block.data)
+		{
+			AudioMix::Add(block, bus);
+			AudioMix::Zero(bus);
+		}
+
+		if (wav)
+			wav->Write(block.data, blockFrames);
+
+		stats.frames += blockFrames;
+
+		// bank samples play silence until they've loaded, which the first
+		// block can catch; after that the loads get the time they would
+		// have had in real time
+		if (bank)
+			bank->WaitForLoads();
+	}
+
+	stats.seconds = double(bx::getHPCounter() - startTick) / double(bx::getHPFrequency());
+
+	const double frequency = double(bx::getHPFrequency());
+	for (int32_t c = 0; c < numTrees; c++)
+		stats.treeSeconds.push_back(double(job.treeTicks[c]) / frequency);
+
+	const int32_t workers = pool ? pool->GetNumWorkers() : 1;
+	for (int32_t w = 0; w < workers; w++)
+		stats.workerSeconds.push_back(double(job.workerTicks[w]) / frequency);
+
+	for (float * output : job.outputs)
+		AudioBuffer::Free(output);
+	AudioBuffer::Free(block.data);
+	if (bus.data != block.data)
+		AudioBuffer::Free(bus.data);
+
+	return stats;
+}
+
+static void FreeTrees(std::vector<AudioWriter::Base*> & trees)
+{
+	for (auto * root : trees)
+		delete root;
+	trees.clear();
+}
+
+// renders the same scores at each rate, without writing, and reports how
+// the cost of one second of audio scales with the rate
+static int RunBenchmark(const char * scoreList, int32_t blockFrames, float maxSeconds, const AudioWriter::Context & settings)
+{
+	const int32_t numRates = sizeof(kBenchRates) / sizeof(kBenchRates[0]);
+	RenderStats stats[numRates];
+	double referenceCost = 0.0;
+
+	for (int32_t c = 0; c < numRates; c++)
+	{
+		const int32_t hertz = kBenchRates[c];
+
+		AudioWriter::Context context = settings;
+		context.hertz = hertz;
+		context.maxBlockFrames = blockFrames;
+		context.retireFrames = int32_t(kRetireSeconds * float(hertz));
+		AudioWriter::SetContext(context);
+
+		std::vector<AudioWriter::Base*> trees;
+		if (!BuildScores(scoreList, trees))
+			return EXIT_FAILURE;
+
+		const uint64_t maxFrames = uint64_t(double(maxSeconds) * hertz);
+		stats[c] = RenderTrees(trees, blockFrames, maxFrames, nullptr);
+		FreeTrees(trees);
+
+		if (hertz == kBenchReferenceRate)
+			referenceCost = 1.0 / stats[c].RealTimeFactor(hertz);
+	}
+
+	printf("%-8s %10s %10s %12s %12s\n", "hertz", "audio s", "cpu ms", "x real time", "vs 48k");
+
+	for (int32_t c = 0; c < numRates; c++)
+	{
+		const int32_t hertz = kBenchRates[c];
+
+		// cpu seconds per second of audio, against the reference rate
+		const double cost = 1.0 / stats[c].RealTimeFactor(hertz);
+
+		printf("%-8d %10.2f %10.1f %12.1f %11.2fx\n"
+			, hertz
+			, stats[c].AudioSeconds(hertz)
+			, stats[c].seconds * 1000.0
+			, stats[c].RealTimeFactor(hertz)
+			, referenceCost > 0.0 ? cost / referenceCost : 0.0
+			);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// renders the same scores at each block size, whole and in sub-blocks,
+// without writing; big blocks are where sub-blocks should pay, since a
+// whole block streams through memory once per writer
+static int RunBlockBenchmark(const char * scoreList, float maxSeconds, const AudioWriter::Context & settings)
+{
+	const int32_t numBlocks = sizeof(kBenchBlocks) / sizeof(kBenchBlocks[0]);
+	const int32_t subBlockFrames = settings.subBlockFrames > 0 ? settings.subBlockFrames : kBenchSubBlockFrames;
+	const uint64_t maxFrames = uint64_t(double(maxSeconds) * settings.hertz);
+
+	printf("sub-blocks of %d frames\n", subBlockFrames);
+	printf("%-8s %14s %14s %10s\n", "block", "whole x real", "sub x real", "speedup");
+
+	for (int32_t c = 0; c < numBlocks; c++)
+	{
+		const int32_t blockFrames = kBenchBlocks[c];
+		double best[2] = {};
+
+		for (int32_t run = 0; run < 2 * kBenchRepeats; run++)
+		{
+			const int32_t pass = run & 1;
+
+			AudioWriter::Context context = settings;
+			context.maxBlockFrames = blockFrames;
+			context.subBlockFrames = pass == 0 ? 0 : subBlockFrames;
+			AudioWriter::SetContext(context);
+
+			std::vector<AudioWriter::Base*> trees;
+			if (!BuildScores(scoreList, trees))
+				return EXIT_FAILURE;
+
+			const double factor = RenderTrees(trees, blockFrames, maxFrames, nullptr).RealTimeFactor(settings.hertz);
+			best[pass] = factor > best[pass] ? factor : best[pass];
+			FreeTrees(trees);
+		}
+
+		const double whole = best[0];
+		const double sub = best[1];
+		printf("%-8d %14.1f %14.1f %9.2fx\n", blockFrames, whole, sub, whole > 0.0 ? sub / whole : 0.0);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, const char * argv[])
+{
+	bx::CommandLine cmdLine(argc, argv);
+
+	if (cmdLine.hasArg('h', "help"))
+	{
+		PrintUsage();
+		return EXIT_SUCCESS;
+	}
+
+	const char * scoreList = cmdLine.findOption('s', "score", "melody,harmony");
+	const char * outputPath = cmdLine.findOption('o', "output", "render.wav");
+	const bool writeOutput = !cmdLine.hasArg("no-output");
+
+	AudioWriter::Context context;
+	cmdLine.hasArg(context.hertz, 'r', "hertz");
+
+	int32_t blockFrames = 512;
+	cmdLine.hasArg(blockFrames, 'b', "block");
+
+	// the trees still render mono, and are panned onto these
+	int32_t outputChannels = 1;
+	cmdLine.hasArg(outputChannels, 'c', "channels");
+
+	float maxSeconds = 600.0f;
+	cmdLine.hasArg(maxSeconds, 't', "max-seconds");
+
+	// there's no deadline offline, so no governor; a fixed lod shows what
+	// each tier costs and sounds like
+	cmdLine.hasArg(context.lod, 'l', "lod");
+
+	if (context.hertz <= 0 || blockFrames <= 0 || maxSeconds <= 0.0f)
+	{
+		fprintf(stderr, "hertz, block and max-seconds must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	if (outputChannels < 1 || outputChannels > AudioMix::kMaxChannels)
+	{
+		fprintf(stderr, "channels must be between 1 and %d\n", AudioMix::kMaxChannels);
+		return EXIT_FAILURE;
+	}
+
+	if (context.lod < 0 || context.lod > AudioWriter::kMaxLod)
+	{
+		fprintf(stderr, "lod must be between 0 and %d\n", AudioWriter::kMaxLod);
+		return EXIT_FAILURE;
+	}
+
+	float retireDecibels = 0.0f;
+	if (cmdLine.hasArg(retireDecibels, '\0', "retire"))
+	{
+		if (retireDecibels >= 0.0f)
+		{
+			fprintf(stderr, "retire is in dBFS, and has to be below 0\n");
+			return EXIT_FAILURE;
+		}
+
+		context.retireLevel = powf(10.0f, retireDecibels / 20.0f);
+		context.retireFrames = int32_t(kRetireSeconds * float(context.hertz));
+	}
+
+	if (blockFrames > kMaxBlockFrames)
+	{
+		fprintf(stderr, "block can be at most %d frames\n", kMaxBlockFrames);
+		return EXIT_FAILURE;
+	}
+
+	cmdLine.hasArg(context.subBlockFrames, '\0', "sub-block");
+	if (context.subBlockFrames < 0)
+	{
+		fprintf(stderr, "sub-block can't be negative\n");
+		return EXIT_FAILURE;
+	}
+
+	// ParallelComposite picks the pool up on its own
+	JobPool jobs;
+	JobPool::Config jobsConfig;
+	cmdLine.hasArg(jobsConfig.threads, 'j', "threads");
+	jobs.Init(jobsConfig);
+
+	SampleStreamer streamer;
+	SampleStreamer::Config streamerConfig;
+	streamerConfig.mapLimit = kSampleMapLimit;
+	streamerConfig.prefetchThread = false;
+	streamer.Init(streamerConfig);
+
+	// loads as background jobs when the pool has workers to run them
+	SampleBank bank;
+	SampleBank::Config bankConfig;
+	bankConfig.budgetBytes = kSampleBankBudget;
+	bank.Init(bankConfig);
+
+	if (cmdLine.hasArg("bench"))
+		return RunBenchmark(scoreList, blockFrames, maxSeconds, context);
+
+	if (cmdLine.hasArg("bench-blocks"))
+		return RunBlockBenchmark(scoreList, maxSeconds, context);
+
+	context.maxBlockFrames = blockFrames;
+	AudioWriter::SetContext(context);
+
+	std::vector<AudioWriter::Base*> trees;
+	if (!BuildScores(scoreList, trees))
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	WavWriter wav;
+	if (writeOutput && !wav.Open(outputPath, context.hertz, outputChannels))
+	{
+		fprintf(stderr, "couldn't open '%s' for writing\n", outputPath);
+		return EXIT_FAILURE;
+	}
+
+	const uint64_t maxFrames = uint64_t(double(maxSeconds) * context.hertz);
+	const bool parallelStreams = cmdLine.hasArg("parallel-streams");
+	RenderStats stats = RenderTrees(trees, blockFrames, maxFrames, writeOutput ? &wav : nullptr, parallelStreams ? &jobs : nullptr, outputChannels);
+	wav.Close();
+
+	// declared by pipeline stages; the wav carries it as leading silence
+	int32_t latencyFrames = 0;
+	for (auto * root : trees)
+	{
+		const int32_t treeLatency = root ? root->GetLatencyFrames() : 0;
+		latencyFrames = treeLatency > latencyFrames ? treeLatency : latencyFrames;
+	}
+
+	FreeTrees(trees);
+
+	printf("rendered %.2fs of audio at %d Hz, %d channels, block %d, %d workers, in %.3fs: %.1fx real time\n"
+		, stats.AudioSeconds(context.hertz)
+		, context.hertz
+		, outputChannels
+		, blockFrames
+		, jobs.GetNumWorkers()
+		, stats.seconds
+		, stats.RealTimeFactor(context.hertz)
+		);
+
+	if (latencyFrames > 0)
+		printf("  pipeline latency %d frames, %.1fms\n", latencyFrames, 1000.0 * latencyFrames / context.hertz);
+
+	if (bank.GetResidentBytes() > 0)
+		printf("  sample bank %.0fKB resident, budget %.0fKB\n", bank.GetResidentBytes() / 1024.0, kSampleBankBudget / 1024.0);
+
+	if (parallelStreams)
+	{
+		for (size_t c = 0; c < stats.treeSeconds.size(); c++)
+			printf("  score %zu: %.3fs cpu\n", c, stats.treeSeconds[c]);
+
+		for (size_t w = 0; w < stats.workerSeconds.size(); w++)
+			printf("  worker %zu: %.3fs busy, %.0f%%\n", w, stats.workerSeconds[w], stats.seconds > 0.0 ? 100.0 * stats.workerSeconds[w] / stats.seconds : 0.0);
+	}
+
+	if (writeOutput)
+		printf("wrote %s\n", outputPath);
+
+	return EXIT_SUCCESS;
+}